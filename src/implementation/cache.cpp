@@ -0,0 +1,343 @@
+/* inclusions *****************************************************************/
+
+#include "../interface/cache.hpp"
+
+/* constants ******************************************************************/
+
+const Int SUBFORMULA_CACHE_CAPACITY = 1 << 12;
+
+const string &RESULT_FILE_EXTENSION = ".result";
+const string &RESULT_LOCK_FILE_NAME = "lock";
+const Hash RESULT_CACHE_VERSION = 1; // increment when key or entry format changes
+
+const Hash CLAUSE_TAG = 1;
+const Hash SUBFORMULA_TAG = 2;
+const Hash PROJECTION_TAG = 3;
+
+/* classes ********************************************************************/
+
+/* class Hasher ***************************************************************/
+
+void Hasher::mix(Hash word) { // splitmix64 finalizer on two streams
+  Hash h1 = hashes.first ^ word;
+  h1 = (h1 ^ (h1 >> 30)) * 0xbf58476d1ce4e5b9;
+  h1 = (h1 ^ (h1 >> 27)) * 0x94d049bb133111eb;
+  hashes.first = h1 ^ (h1 >> 31);
+
+  Hash h2 = hashes.second + word * 0x9e3779b97f4a7c15;
+  h2 = (h2 ^ (h2 >> 33)) * 0xff51afd7ed558ccd;
+  h2 = (h2 ^ (h2 >> 33)) * 0xc4ceb9fe1a85ec53;
+  hashes.second = h2 ^ (h2 >> 33);
+}
+
+void Hasher::mixFloat(Float f) {
+  Hash word;
+  std::memcpy(&word, &f, sizeof(word));
+  mix(word);
+}
+
+HashPair Hasher::getHashes() const {
+  return hashes;
+}
+
+/* class SubformulaHasher *****************************************************/
+
+Int SubformulaHasher::getCanonicalVar(Int cnfVar) {
+  auto it = canonicalVars.find(cnfVar);
+  if (it != canonicalVars.end()) {
+    return it->second;
+  }
+  Int canonicalVar = cnfVars.size();
+  canonicalVars[cnfVar] = canonicalVar;
+  cnfVars.push_back(cnfVar);
+  return canonicalVar;
+}
+
+void SubformulaHasher::addClause(const vector<Int> &clause) {
+  mix(CLAUSE_TAG);
+  mix(clause.size());
+  for (Int literal : clause) {
+    Int canonicalVar = getCanonicalVar(util::getCnfVar(literal));
+    mix(canonicalVar * 2 + (util::isPositiveLiteral(literal) ? 0 : 1));
+  }
+}
+
+void SubformulaHasher::addSubformula(const SubformulaKey &key) {
+  mix(SUBFORMULA_TAG);
+  mix(key.hashes.first);
+  mix(key.hashes.second);
+  mix(key.boundaryCnfVars.size());
+  for (Int cnfVar : key.boundaryCnfVars) {
+    mix(getCanonicalVar(cnfVar));
+  }
+}
+
+void SubformulaHasher::addProjectedCnfVars(const Set<Int> &projectingCnfVars, const Map<Int, Float> &literalWeights) {
+  vector<Int> occurrentVars; // canonical vars
+  vector<std::pair<Float, Float>> absentVarWeights; // vars outside sub-formula only scale the result
+  for (Int cnfVar : projectingCnfVars) {
+    auto it = canonicalVars.find(cnfVar);
+    if (it != canonicalVars.end()) {
+      occurrentVars.push_back(it->second);
+    }
+    else {
+      absentVarWeights.push_back({literalWeights.at(cnfVar), literalWeights.at(-cnfVar)});
+    }
+    projectedCnfVars.insert(cnfVar);
+  }
+  std::sort(occurrentVars.begin(), occurrentVars.end());
+  std::sort(absentVarWeights.begin(), absentVarWeights.end());
+
+  mix(PROJECTION_TAG);
+  mix(occurrentVars.size());
+  for (Int canonicalVar : occurrentVars) {
+    Int cnfVar = cnfVars.at(canonicalVar);
+    mix(canonicalVar);
+    mixFloat(literalWeights.at(cnfVar));
+    mixFloat(literalWeights.at(-cnfVar));
+  }
+  mix(absentVarWeights.size());
+  for (const auto &weights : absentVarWeights) {
+    mixFloat(weights.first);
+    mixFloat(weights.second);
+  }
+}
+
+SubformulaKey SubformulaHasher::getKey() const {
+  SubformulaKey key;
+  key.hashes = hashes;
+  for (Int cnfVar : cnfVars) {
+    if (projectedCnfVars.find(cnfVar) == projectedCnfVars.end()) {
+      key.boundaryCnfVars.push_back(cnfVar);
+    }
+  }
+  return key;
+}
+
+/* class SubformulaCache ******************************************************/
+
+void SubformulaCache::countOccurrence(const SubformulaKey &key) {
+  occurrenceCounts[key.hashes]++;
+}
+
+bool SubformulaCache::isRecurrent(const SubformulaKey &key) const {
+  auto it = occurrenceCounts.find(key.hashes);
+  return it != occurrenceCounts.end() && it->second > 1;
+}
+
+bool SubformulaCache::lookUp(ADD &dd, Int &ddExponent, Int &roundingCount, vector<Int> &boundaryCnfVars, const SubformulaKey &key) {
+  auto it = entries.find(key.hashes);
+  if (it == entries.end()) {
+    missCount++;
+    return false;
+  }
+  hitCount++;
+
+  Entry &entry = it->second;
+  if (entry.boundaryCnfVars.size() != key.boundaryCnfVars.size()) {
+    showError("hash collision between sub-formulas with " + to_string(entry.boundaryCnfVars.size()) + " and " + to_string(key.boundaryCnfVars.size()) + " boundary vars");
+  }
+  dd = entry.dd;
+  ddExponent = entry.ddExponent;
+  roundingCount = entry.roundingCount;
+  boundaryCnfVars = entry.boundaryCnfVars;
+
+  if (entry.remainingUses != DUMMY_MAX_INT) {
+    entry.remainingUses--;
+    if (entry.remainingUses <= 0) {
+      entries.erase(it);
+    }
+  }
+  return true;
+}
+
+void SubformulaCache::insert(const ADD &dd, Int ddExponent, Int roundingCount, const SubformulaKey &key) {
+  auto it = occurrenceCounts.find(key.hashes);
+  if (it == occurrenceCounts.end() || it->second <= 1) return;
+
+  Entry entry;
+  entry.dd = dd;
+  entry.ddExponent = ddExponent;
+  entry.roundingCount = roundingCount;
+  entry.boundaryCnfVars = key.boundaryCnfVars;
+  entry.remainingUses = it->second - 1;
+  entries[key.hashes] = entry;
+}
+
+void SubformulaCache::insertOnline(const ADD &dd, const SubformulaKey &key) {
+  while (entries.size() >= SUBFORMULA_CACHE_CAPACITY && !insertionOrder.empty()) {
+    entries.erase(insertionOrder.front());
+    insertionOrder.pop_front();
+  }
+
+  Entry entry;
+  entry.dd = dd;
+  entry.boundaryCnfVars = key.boundaryCnfVars;
+  if (entries.find(key.hashes) == entries.end()) {
+    insertionOrder.push_back(key.hashes);
+  }
+  entries[key.hashes] = entry;
+}
+
+void SubformulaCache::printStats() const {
+  util::printRow("subformulaCacheHits", hitCount);
+  util::printRow("subformulaCacheMisses", missCount);
+}
+
+/* class ResultCache **********************************************************/
+
+string ResultCache::getEntryPath(const HashPair &hashes) const {
+  std::ostringstream name;
+  name << std::hex << std::setfill('0') << std::setw(16) << hashes.first << std::setw(16) << hashes.second;
+  return dirPath + "/" + name.str() + RESULT_FILE_EXTENSION;
+}
+
+HashPair ResultCache::getCnfHashes(const Cnf &cnf) {
+  vector<vector<Int>> clauses;
+  for (vector<Int> clause : cnf.getClauses()) {
+    std::sort(clause.begin(), clause.end(), [](Int literal1, Int literal2) {
+      return std::make_pair(std::abs(literal1), literal1) < std::make_pair(std::abs(literal2), literal2);
+    });
+    clause.erase(std::unique(clause.begin(), clause.end()), clause.end());
+    clauses.push_back(clause);
+  }
+  std::sort(clauses.begin(), clauses.end());
+
+  Hasher hasher;
+  hasher.mix(RESULT_CACHE_VERSION);
+  hasher.mix(static_cast<Hash>(cnf.getWeightFormat()));
+  hasher.mix(cnf.getDeclaredVarCount());
+
+  hasher.mix(clauses.size());
+  for (const vector<Int> &clause : clauses) {
+    hasher.mix(clause.size());
+    for (Int literal : clause) hasher.mix(literal);
+  }
+
+  const Map<Int, Float> &literalWeights = cnf.getLiteralWeights();
+  for (Int var = 1; var <= cnf.getDeclaredVarCount(); var++) {
+    hasher.mixFloat(literalWeights.at(var));
+    hasher.mixFloat(literalWeights.at(-var));
+  }
+  return hasher.getHashes();
+}
+
+bool ResultCache::lookUp(ExtendedFloat &modelCount, const HashPair &hashes) const {
+  if (!usable) return false;
+
+  string entryPath = getEntryPath(hashes);
+  std::ifstream entryStream(entryPath);
+  if (!entryStream.is_open()) return false;
+
+  Map<string, string> fields;
+  string line;
+  while (std::getline(entryStream, line)) {
+    size_t separator = line.find(' ');
+    if (separator != string::npos) {
+      fields[line.substr(0, separator)] = line.substr(separator + 1);
+    }
+  }
+  ExtendedFloat count;
+  try { // entry may be corrupt since directory is shared by processes
+    count = std::stod(fields.at("count"));
+    if (fields.find("mantissa") != fields.end() && fields.find("exponent") != fields.end()) { // count may be out of Float range
+      count = ExtendedFloat(std::stod(fields.at("mantissa")), std::stoll(fields.at("exponent")));
+    }
+  }
+  catch (const std::exception &) {
+    unlink(entryPath.c_str()); // not hit again
+    showWarning("ignoring malformed result cache entry '" + entryPath + "'");
+    return false;
+  }
+  modelCount = count;
+
+  utime(entryPath.c_str(), nullptr); // least recently used entries are evicted first
+
+  if (verbosityLevel >= 1) {
+    printComment("Found result cache entry '" + entryPath + "':", 1);
+    for (const char *key : {"source", "seconds", "created"}) {
+      if (fields.find(key) != fields.end()) util::printRow(key, fields.at(key));
+    }
+  }
+  return true;
+}
+
+void ResultCache::insert(const ExtendedFloat &modelCount, const HashPair &hashes, const string &source, Float seconds) const {
+  if (!usable) return;
+
+  string entryPath = getEntryPath(hashes);
+  string tempPath = entryPath + ".tmp" + to_string(getpid());
+  {
+    std::ofstream tempStream(tempPath);
+    if (!tempStream.is_open()) {
+      showWarning("unable to write result cache entry '" + tempPath + "'");
+      return;
+    }
+    tempStream << std::setprecision(17);
+    tempStream << "count " << modelCount.toFloat() << "\n";
+    tempStream << "mantissa " << modelCount.mantissa << "\n";
+    tempStream << "exponent " << modelCount.exponent << "\n";
+    tempStream << "source " << source << "\n";
+    tempStream << "seconds " << seconds << "\n";
+    tempStream << "created " << time(nullptr) << "\n";
+  }
+  if (rename(tempPath.c_str(), entryPath.c_str()) != 0) { // readers never see partial entries
+    unlink(tempPath.c_str());
+    showWarning("unable to rename result cache entry '" + tempPath + "'");
+  }
+}
+
+void ResultCache::evict() const {
+  if (!usable) return;
+
+  string lockPath = dirPath + "/" + RESULT_LOCK_FILE_NAME;
+  int lockFd = open(lockPath.c_str(), O_CREAT | O_RDWR, 0644);
+  if (lockFd < 0 || flock(lockFd, LOCK_EX) != 0) { // serializes evictions by concurrent processes
+    showWarning("unable to lock result cache '" + lockPath + "'");
+    if (lockFd >= 0) close(lockFd);
+    return;
+  }
+
+  vector<std::pair<time_t, string>> entries; // (last use, path)
+  Float totalBytes = 0;
+  DIR *dir = opendir(dirPath.c_str());
+  if (dir != nullptr) {
+    while (dirent *entry = readdir(dir)) {
+      string name = entry->d_name;
+      if (name.size() <= RESULT_FILE_EXTENSION.size() || name.compare(name.size() - RESULT_FILE_EXTENSION.size(), RESULT_FILE_EXTENSION.size(), RESULT_FILE_EXTENSION) != 0) continue;
+
+      string path = dirPath + "/" + name;
+      struct stat status;
+      if (stat(path.c_str(), &status) == 0) {
+        entries.push_back({status.st_mtime, path});
+        totalBytes += status.st_size;
+      }
+    }
+    closedir(dir);
+  }
+
+  Float maxBytes = maxMegabytes * (1 << 20);
+  if (totalBytes > maxBytes) {
+    std::sort(entries.begin(), entries.end());
+    for (const auto &entry : entries) {
+      if (totalBytes <= maxBytes) break;
+      struct stat status;
+      if (stat(entry.second.c_str(), &status) == 0 && unlink(entry.second.c_str()) == 0) {
+        totalBytes -= status.st_size;
+      }
+    }
+  }
+
+  flock(lockFd, LOCK_UN);
+  close(lockFd);
+}
+
+ResultCache::ResultCache(const string &dirPath, Float maxMegabytes) {
+  this->dirPath = dirPath;
+  this->maxMegabytes = maxMegabytes;
+
+  if (mkdir(dirPath.c_str(), 0755) != 0 && errno != EEXIST) {
+    showWarning("unable to create result cache directory '" + dirPath + "'; not caching");
+    usable = false;
+  }
+}
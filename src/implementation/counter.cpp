@@ -2,6 +2,12 @@
 
 #include "../interface/counter.hpp"
 
+/* constants ******************************************************************/
+
+const Float COUNTING_SECONDS_PER_JOIN_TREE_COST = 1e-7;
+const Float MAX_EXACT_FLOAT_INT = 9007199254740992.0;
+const Int RESCALING_MIN_EXPONENT = 64;
+
 /* namespaces *****************************************************************/
 
 /* namespace dd ***************************************************************/
@@ -31,138 +37,1678 @@ Int diagram::countConstDdInt(const ADD &dd) {
 
   if (!util::isInt(value)) showError("unweighted model count is not int");
 
-  return value;
+  return value;
+}
+
+string diagram::countBddMintermsExactly(const BDD &bdd, Int varCount) {
+  int digitCount;
+  DdApaNumber count = Cudd_ApaCountMinterm(bdd.manager(), bdd.getNode(), varCount, &digitCount);
+  if (count == nullptr) showError("unable to count minterms of BDD (out of memory)");
+
+  char *decimal = Cudd_ApaStringDecimal(digitCount, count);
+  Cudd_FreeApaNumber(count);
+  if (decimal == nullptr) showError("unable to print minterm count of BDD (out of memory)");
+
+  string modelCount(decimal);
+  free(decimal);
+  return modelCount;
+}
+
+void diagram::printMaxDdVarCount(Int maxDdVarCount) {
+  util::printRow("maxAddVarCount", maxDdVarCount);
+}
+
+/* classes ********************************************************************/
+
+/* semirings ******************************************************************/
+
+Float SumProduct::getTerminal(Float weight) {
+  return weight;
+}
+
+DdNode *SumProduct::addTerminals(DdManager *ddManager, DdNode **f, DdNode **g) {
+  return Cudd_addPlus(ddManager, f, g);
+}
+
+DdNode *SumProduct::multiplyTerminals(DdManager *ddManager, DdNode **f, DdNode **g) {
+  return Cudd_addTimes(ddManager, f, g);
+}
+
+Float MaxProduct::getTerminal(Float weight) {
+  return weight;
+}
+
+DdNode *MaxProduct::addTerminals(DdManager *ddManager, DdNode **f, DdNode **g) {
+  return Cudd_addMaximum(ddManager, f, g);
+}
+
+DdNode *MaxProduct::multiplyTerminals(DdManager *ddManager, DdNode **f, DdNode **g) {
+  return Cudd_addTimes(ddManager, f, g);
+}
+
+Float LogSumExp::getTerminal(Float weight) {
+  return weight == 0 ? NEGATIVE_INFINITY : std::log(weight);
+}
+
+DdNode *LogSumExp::addTerminals(DdManager *ddManager, DdNode **f, DdNode **g) {
+  DdNode *F = *f;
+  DdNode *G = *g;
+  if (!cuddIsConstant(F) || !cuddIsConstant(G)) return nullptr; // recurs into children
+
+  Float maxValue = std::max(cuddV(F), cuddV(G));
+  Float minValue = std::min(cuddV(F), cuddV(G));
+  if (minValue == NEGATIVE_INFINITY) return maxValue == cuddV(F) ? F : G; // adds 0
+  return cuddUniqueConst(ddManager, maxValue + std::log1p(std::exp(minValue - maxValue))); // stable for large magnitudes
+}
+
+DdNode *LogSumExp::multiplyTerminals(DdManager *ddManager, DdNode **f, DdNode **g) {
+  return Cudd_addPlus(ddManager, f, g);
+}
+
+DdNode *LogSumExp::convertIndicatorTerminal(DdManager *ddManager, DdNode *node) {
+  if (!cuddIsConstant(node)) return nullptr;
+
+  return cuddUniqueConst(ddManager, getTerminal(cuddV(node)));
+}
+
+Float ModularSumProduct::getTerminal(Float weight) {
+  return util::getResidue(weight, terminalModulus);
+}
+
+DdNode *ModularSumProduct::addTerminals(DdManager *ddManager, DdNode **f, DdNode **g) {
+  DdNode *F = *f;
+  DdNode *G = *g;
+  if (!cuddIsConstant(F) || !cuddIsConstant(G)) return nullptr;
+
+  return cuddUniqueConst(ddManager, (Int(cuddV(F)) + Int(cuddV(G))) % terminalModulus);
+}
+
+DdNode *ModularSumProduct::multiplyTerminals(DdManager *ddManager, DdNode **f, DdNode **g) {
+  DdNode *F = *f;
+  DdNode *G = *g;
+  if (!cuddIsConstant(F) || !cuddIsConstant(G)) return nullptr;
+
+  return cuddUniqueConst(ddManager, util::multiplyModularly(cuddV(F), cuddV(G), terminalModulus)); // residues are exact as Float
+}
+
+/* class Counter **************************************************************/
+
+WeightFormat Counter::weightFormat;
+bool Counter::checkpointing = false;
+volatile sig_atomic_t Counter::checkpointRequested = 0;
+Int Counter::roundingBits = 0;
+
+void Counter::handleSignals(int signal) {
+  cout << "\n";
+  util::printDuration(startTime);
+  cout << "\n";
+
+  util::printSolutionLine(weightFormat, ExtendedFloat(0), 0, 0);
+  showError("received system signal " + to_string(signal) + "; printed dummy model count");
+}
+
+void Counter::handleTermination(int signal) {
+  if (checkpointing) {
+    checkpointRequested = 1; // ADDs are consistent only between operations
+  }
+  else {
+    handleSignals(signal);
+  }
+}
+
+DdNode *Counter::roundTerminal(DdManager *ddManager, DdNode *node) {
+  if (!cuddIsConstant(node)) return nullptr; // recurs into children
+
+  Float value = cuddV(node);
+  if (value == 0 || !std::isfinite(value)) return node;
+
+  int exponent;
+  Float mantissa = std::frexp(value, &exponent); // 0.5 <= |mantissa| < 1
+  Float roundedMantissa = std::ldexp(std::round(std::ldexp(mantissa, roundingBits)), -roundingBits);
+  return cuddUniqueConst(ddManager, std::ldexp(roundedMantissa, exponent));
+}
+
+void Counter::startCheckpointing(const Cnf &cnf, const string &algorithm) {
+  resuming = false;
+  restoredCheckpoint = Checkpoint();
+  restoredFrameIndices.clear();
+  subtreeFrames.clear();
+  if (checkpointDir == DUMMY_STR) return;
+
+  checkpointing = true;
+  checkpointAlgorithm = algorithm + (extendedRange ? " extended range" : ""); // ADDs are rescaled
+  if (epsilon > 0) checkpointAlgorithm += " epsilon " + to_string(epsilon); // terminals are rounded
+  if (semiring != Semiring::SUM_PRODUCT) checkpointAlgorithm += " semiring " + to_string(static_cast<Int>(semiring)); // terminals have other meanings
+  if (localDdVars) checkpointAlgorithm += " local dd vars"; // ddVarOrdering has free ddVars
+  if (!queryCnfVars.empty()) { // query vars are not projected
+    vector<Int> sortedQueryCnfVars(queryCnfVars.begin(), queryCnfVars.end());
+    std::sort(sortedQueryCnfVars.begin(), sortedQueryCnfVars.end());
+    checkpointAlgorithm += " query";
+    for (Int cnfVar : sortedQueryCnfVars) checkpointAlgorithm += " " + to_string(cnfVar);
+  }
+  cnfHashes = ResultCache::getCnfHashes(cnf);
+  checkpointTime = util::getTimePoint();
+  if (!resumingCheckpoint) return;
+
+  Checkpoint checkpoint;
+  if (!checkpoint.readMetadata(checkpointDir)) {
+    printComment("No checkpoint in '" + checkpointDir + "'; counting from start", 1);
+  }
+  else if (checkpoint.cnfHashes != cnfHashes || checkpoint.algorithm != checkpointAlgorithm) {
+    showWarning("checkpoint in '" + checkpointDir + "' is for another cnf or algorithm; counting from start");
+  }
+  else {
+    restoredCheckpoint = checkpoint;
+    resuming = true;
+    if (verbosityLevel >= 1) {
+      printComment("Resuming from checkpoint in '" + checkpointDir + "'", 1);
+    }
+  }
+}
+
+void Counter::finishCheckpointing() {
+  if (checkpointing) {
+    Checkpoint::remove(checkpointDir);
+    checkpointing = false;
+  }
+  resuming = false;
+  restoredCheckpoint = Checkpoint();
+}
+
+bool Counter::isCheckpointDue() const {
+  return checkpointing && (checkpointRequested || util::getSeconds(checkpointTime) >= checkpointSeconds);
+}
+
+void Counter::saveCheckpoint(Checkpoint &checkpoint, Int position, const Set<Int> &projectedCnfVars) {
+  checkpoint.algorithm = checkpointAlgorithm;
+  checkpoint.cnfHashes = cnfHashes;
+  checkpoint.position = position;
+  checkpoint.ddExponent = ddExponent;
+  checkpoint.roundingCount = roundingCount;
+  checkpoint.ddVarOrdering = ddVarToCnfVarMap;
+  if (localDdVars) {
+    for (Int ddVar = 0; ddVar < ddVarToCnfVarMap.size(); ddVar++) {
+      checkpoint.ddVarLevels.push_back(Cudd_ReadPerm(mgr.getManager(), ddVar));
+    }
+  }
+  checkpoint.projectedCnfVars = vector<Int>(projectedCnfVars.begin(), projectedCnfVars.end());
+  checkpoint.write(checkpointDir);
+  checkpointTime = util::getTimePoint();
+
+  if (verbosityLevel >= 1) {
+    printComment("Wrote checkpoint with " + to_string(checkpoint.dds.size()) + " ADDs to '" + checkpointDir + "'", 1);
+  }
+
+  if (checkpointRequested) {
+    spillManager.removeFiles(); // checkpoint holds spilled ADDs
+
+    cout << "\n";
+    util::printDuration(startTime);
+    cout << "\n";
+
+    showError("received SIGTERM; wrote checkpoint to '" + checkpointDir + "'");
+  }
+}
+
+void Counter::saveJoinTreeCheckpoint() {
+  Checkpoint checkpoint;
+  for (const SubtreeFrame &frame : subtreeFrames) {
+    checkpoint.dds.push_back(getSubtreeFrameDd(frame));
+    checkpoint.ddTags.push_back(frame.nodeIndex);
+    checkpoint.ddPositions.push_back(frame.finishedChildCount);
+  }
+  saveCheckpoint(checkpoint, DUMMY_MIN_INT, Set<Int>());
+}
+
+void Counter::addJoinTreeHashes(Hasher &hasher, JoinNode *joinRoot) const {
+  vector<std::pair<JoinNode *, vector<JoinNode *>>> stack; // node, unvisited children in reverse execution order; iterative for deep trees
+  JoinNode *joinNode = joinRoot;
+  while (true) {
+    if (joinNode != nullptr) { // visits node
+      hasher.mix(joinNode->getNodeIndex());
+      hasher.mix(joinNode->getChildren().size());
+      vector<JoinNode *> children = joinNode->isTerminal() ? vector<JoinNode *>() : getExecutionChildren(joinNode);
+      util::invert(children);
+      stack.push_back({joinNode, children});
+    }
+    if (stack.empty()) return;
+
+    vector<JoinNode *> &children = stack.back().second;
+    if (!children.empty()) {
+      util::popBack(joinNode, children);
+    }
+    else { // finishes node
+      Span<Int> span = stack.back().first->getProjectableCnfVars();
+      vector<Int> projectableCnfVars(span.begin(), span.end());
+      std::sort(projectableCnfVars.begin(), projectableCnfVars.end());
+      hasher.mix(projectableCnfVars.size());
+      for (Int cnfVar : projectableCnfVars) hasher.mix(cnfVar);
+
+      stack.pop_back();
+      joinNode = nullptr;
+    }
+  }
+}
+
+void Counter::startSpilling() {
+  spillManager = spillDir == DUMMY_STR ? SpillManager() : SpillManager(spillDir, spillMegabytes);
+}
+
+void Counter::finishSpilling() {
+  if (spillDir != DUMMY_STR && verbosityLevel >= 1) {
+    spillManager.printStats();
+  }
+  spillManager.removeFiles();
+}
+
+void Counter::spillSubtreeFrames() {
+  for (SubtreeFrame &frame : subtreeFrames) { // outer frames resume last
+    if (!spillManager.isUnderPressure(mgr)) return;
+
+    if (spillManager.isWorthSpilling(frame.dd)) {
+      Int spillId = spillManager.spill(frame.dd);
+      if (spillId == DUMMY_MIN_INT) return;
+
+      frame.spilledDdIds.push_back(spillId);
+      frame.dd = getOneDd();
+    }
+    for (Int i = frame.childDds.size() - 1; i >= 0; i--) {
+      if (!spillManager.isUnderPressure(mgr)) return;
+      if (!spillManager.isWorthSpilling(frame.childDds.at(i))) continue;
+
+      Int spillId = spillManager.spill(frame.childDds.at(i));
+      if (spillId == DUMMY_MIN_INT) return;
+
+      frame.spilledDdIds.push_back(spillId);
+      frame.childDds.erase(frame.childDds.begin() + i);
+    }
+  }
+}
+
+ADD Counter::getSubtreeFrameDd(const SubtreeFrame &frame) const {
+  ADD dd = frame.dd;
+  for (const ADD &childDd : frame.childDds) {
+    multiplyDds(dd, childDd);
+  }
+  for (Int spillId : frame.spilledDdIds) {
+    multiplyDds(dd, spillManager.peek(spillId, mgr));
+  }
+  if (frame.constantFactor != 1) {
+    multiplyDds(dd, mgr.constant(frame.constantFactor));
+  }
+  return dd;
+}
+
+bool Counter::isSpeculating() const {
+  return joinTreeReader != nullptr && jtRestartRatio > 0;
+}
+
+void Counter::addJoinNodeCosts(Map<Int, Float> &joinNodeCosts, JoinNode *joinRoot, const Cnf &cnf) const {
+  Map<Int, Set<Int>> remainingCnfVarSets; // nonterminal index |-> cnf vars of subtree after projection; erased once parent is costed
+  for (JoinNode *joinNode : joinRoot->getPostorder()) {
+    Set<Int> &cnfVars = remainingCnfVarSets[joinNode->getNodeIndex()];
+    for (JoinNode *child : joinNode->getChildren()) {
+      if (child->isTerminal()) {
+        util::unionize(cnfVars, util::getClauseCnfVars(cnf.getClauses().at(child->getNodeIndex())));
+      }
+      else {
+        util::unionize(cnfVars, remainingCnfVarSets.at(child->getNodeIndex()));
+        remainingCnfVarSets.erase(child->getNodeIndex());
+      }
+    }
+    joinNodeCosts[joinNode->getNodeIndex()] = std::exp2(std::min(cnfVars.size(), (size_t)1000)); // ADD size bound; finite
+
+    for (Int cnfVar : joinNode->getProjectableCnfVars()) {
+      cnfVars.erase(cnfVar);
+    }
+  }
+}
+
+Float Counter::getJoinTreeCost(const Map<Int, Float> &joinNodeCosts) const {
+  Float joinTreeCost = 0;
+  for (const auto &kv : joinNodeCosts) joinTreeCost += kv.second;
+  return joinTreeCost;
+}
+
+Float Counter::predictCountingSeconds(JoinNode *joinRoot, const Cnf &cnf) const {
+  Map<Int, Float> joinNodeCosts;
+  addJoinNodeCosts(joinNodeCosts, joinRoot, cnf);
+  return getJoinTreeCost(joinNodeCosts) * COUNTING_SECONDS_PER_JOIN_TREE_COST;
+}
+
+bool Counter::isRestartDue(const Cnf &cnf) {
+  Int latestJoinTreeCount;
+  JoinNode *latestJoinRoot = joinTreeReader->getJoinTreeRoot(latestJoinTreeCount);
+  if (latestJoinTreeCount == joinTreeCount) return false;
+  joinTreeCount = latestJoinTreeCount;
+
+  Map<Int, Float> latestJoinNodeCosts;
+  addJoinNodeCosts(latestJoinNodeCosts, latestJoinRoot, cnf);
+  Float latestJoinTreeCost = getJoinTreeCost(latestJoinNodeCosts);
+  if (verbosityLevel >= 1) {
+    printComment("Join tree " + to_string(joinTreeCount) + " has estimated cost " + to_string(latestJoinTreeCost) + " (remaining cost " + to_string(remainingJoinTreeCost) + ")", 1);
+  }
+  if (latestJoinTreeCost * jtRestartRatio >= remainingJoinTreeCost) return false;
+
+  nextJoinRoot = latestJoinRoot;
+  return true;
+}
+
+void Counter::writeDotFile(ADD &dd, const string &dotFileDir) {
+  writeDd(mgr, dd, dotFileDir + "dd" + to_string(dotFileIndex) + ".dot");
+  dotFileIndex++;
+}
+
+const vector<Int> &Counter::getDdVarOrdering() const {
+  return ddVarToCnfVarMap;
+}
+
+void Counter::orderDdVars(const Cnf &cnf) {
+  ddVarToCnfVarMap = resuming ? restoredCheckpoint.ddVarOrdering : cnf.getVarOrdering(ddVarOrderingHeuristic, inverseDdVarOrdering);
+  for (Int ddVar = 0; ddVar < ddVarToCnfVarMap.size(); ddVar++) {
+    Int cnfVar = ddVarToCnfVarMap.at(ddVar);
+    cnfVarToDdVarMap[cnfVar] = ddVar;
+    mgr.addVar(ddVar); // creates ddVar-th ADD var
+  }
+  ddExponent = resuming ? restoredCheckpoint.ddExponent : 0;
+  roundingCount = resuming ? restoredCheckpoint.roundingCount : 0;
+
+  if (resuming) {
+    restoredCheckpoint.readDds(checkpointDir, mgr);
+  }
+}
+
+void Counter::startLocalDdVars(const Cnf &cnf) {
+  cnfVarRanks.assign(cnf.getDeclaredVarCount() + 1, DUMMY_MAX_INT);
+  Int rank = 0;
+  for (Int cnfVar : cnf.getVarOrdering(ddVarOrderingHeuristic, inverseDdVarOrdering)) {
+    cnfVarRanks.at(cnfVar) = rank++;
+  }
+  for (Int cnfVar = 1; cnfVar < cnfVarRanks.size(); cnfVar++) { // vars in no clause
+    if (cnfVarRanks.at(cnfVar) == DUMMY_MAX_INT) cnfVarRanks.at(cnfVar) = rank++;
+  }
+
+  if (resuming) { // recreates missing ddVars in their relative order from checkpoint
+    const vector<Int> &ddVarLevels = restoredCheckpoint.ddVarLevels;
+    for (Int ddVar = mgr.ReadSize(); ddVar < ddVarLevels.size(); ddVar++) {
+      Int level = 0;
+      for (Int ddVar2 = 0; ddVar2 < ddVar; ddVar2++) {
+        if (ddVarLevels.at(ddVar2) < ddVarLevels.at(ddVar)) level++;
+      }
+      mgr.addNewVarAtLevel(level);
+    }
+  }
+  ddVarToCnfVarMap = resuming ? restoredCheckpoint.ddVarOrdering : vector<Int>();
+  ddVarToCnfVarMap.resize(mgr.ReadSize(), 0); // ddVars of previous counts are free
+  cnfVarToDdVarMap.clear();
+  liveDdVars.clear();
+  for (Int ddVar = 0; ddVar < ddVarToCnfVarMap.size(); ddVar++) {
+    Int cnfVar = ddVarToCnfVarMap.at(ddVar);
+    if (cnfVar != 0) {
+      cnfVarToDdVarMap[cnfVar] = ddVar;
+      liveDdVars[cnfVarRanks.at(cnfVar)] = ddVar;
+    }
+  }
+  ddExponent = resuming ? restoredCheckpoint.ddExponent : 0;
+  roundingCount = resuming ? restoredCheckpoint.roundingCount : 0;
+
+  if (resuming) {
+    restoredCheckpoint.readDds(checkpointDir, mgr);
+  }
+}
+
+void Counter::compactDdVars() {
+  DdManager *ddManager = mgr.getManager();
+  vector<int> freeDdVars; // in level order
+  for (Int level = 0; level < mgr.ReadSize(); level++) {
+    Int ddVar = Cudd_ReadInvPerm(ddManager, level);
+    if (ddVarToCnfVarMap.at(ddVar) == 0) freeDdVars.push_back(ddVar);
+  }
+
+  Int gapSize = freeDdVars.size() / (liveDdVars.size() + 1);
+  vector<int> permutation; // level |-> ddVar
+  auto freeDdVar = freeDdVars.begin();
+  for (Int i = 0; i < gapSize; i++) permutation.push_back(*freeDdVar++);
+  for (const auto &kv : liveDdVars) { // by rank
+    permutation.push_back(kv.second);
+    for (Int i = 0; i < gapSize; i++) permutation.push_back(*freeDdVar++);
+  }
+  permutation.insert(permutation.end(), freeDdVar, freeDdVars.end());
+  mgr.ShuffleHeap(permutation.data()); // only free ddVars move past live ones, whose ADD nodes keep their order
+
+  ddVarCompactionCount++;
+}
+
+Int Counter::assignDdVar(Int cnfVar) {
+  auto it = cnfVarToDdVarMap.find(cnfVar);
+  if (it != cnfVarToDdVarMap.end()) return it->second;
+
+  DdManager *ddManager = mgr.getManager();
+  Int rank = cnfVarRanks.at(cnfVar);
+  auto next = liveDdVars.upper_bound(rank);
+  auto isFreeLevelNext = [&](Int &level) { // just below previous live var and above next one
+    level = next == liveDdVars.begin() ? 0 : Cudd_ReadPerm(ddManager, std::prev(next)->second) + 1;
+    Int endLevel = next == liveDdVars.end() ? mgr.ReadSize() : Cudd_ReadPerm(ddManager, next->second);
+    return level < endLevel && ddVarToCnfVarMap.at(Cudd_ReadInvPerm(ddManager, level)) == 0; // levels between live neighbours are free
+  };
+
+  Int level;
+  bool freeLevel = isFreeLevelNext(level);
+  Int freeDdVarCount = mgr.ReadSize() - liveDdVars.size();
+  if (!freeLevel && freeDdVarCount > 2 * (liveDdVars.size() + 1)) {
+    compactDdVars();
+    freeLevel = isFreeLevelNext(level);
+  }
+
+  Int ddVar;
+  if (freeLevel) {
+    ddVar = Cudd_ReadInvPerm(ddManager, level);
+  }
+  else {
+    mgr.addNewVarAtLevel(level); // shifts lower levels without reordering
+    ddVar = mgr.ReadSize() - 1;
+    ddVarToCnfVarMap.push_back(0);
+  }
+
+  ddVarToCnfVarMap.at(ddVar) = cnfVar;
+  cnfVarToDdVarMap[cnfVar] = ddVar;
+  liveDdVars[rank] = ddVar;
+  maxLiveDdVarCount = std::max(maxLiveDdVarCount, (Int)liveDdVars.size());
+  return ddVar;
+}
+
+void Counter::releaseDdVar(Int cnfVar) {
+  auto it = cnfVarToDdVarMap.find(cnfVar);
+  if (it == cnfVarToDdVarMap.end()) return;
+
+  ddVarToCnfVarMap.at(it->second) = 0;
+  liveDdVars.erase(cnfVarRanks.at(cnfVar));
+  cnfVarToDdVarMap.erase(it);
+}
+
+ADD Counter::getClauseDd(const vector<Int> &clause) const {
+  DdManager *ddManager = mgr.getManager();
+  vector<std::pair<Int, Int>> levelLiterals; // (level of ddVar, literal)
+  for (Int literal : clause) {
+    Int ddVar = cnfVarToDdVarMap.at(util::getCnfVar(literal));
+    levelLiterals.push_back({Cudd_ReadPerm(ddManager, ddVar), literal});
+  }
+  std::sort(levelLiterals.begin(), levelLiterals.end(), std::greater<std::pair<Int, Int>>()); // bottom level first
+
+  /* chain of unique-table nodes, built bottom-up without apply calls: */
+  ADD one = getOneDd();
+  ADD clauseDd = getZeroDd();
+  for (Int i = 0; i < levelLiterals.size(); i++) {
+    Int literal = levelLiterals.at(i).second;
+    if (i > 0 && levelLiterals.at(i - 1).first == levelLiterals.at(i).first) { // repeated var
+      if (levelLiterals.at(i - 1).second != literal) return one; // tautology
+      continue;
+    }
+
+    Int ddVar = cnfVarToDdVarMap.at(util::getCnfVar(literal));
+    bool positive = util::isPositiveLiteral(literal);
+    DdNode *node = cuddUniqueInter(ddManager, ddVar, positive ? one.getNode() : clauseDd.getNode(), positive ? clauseDd.getNode() : one.getNode());
+    if (node == nullptr) {
+      showError("unable to build ADD for clause (out of memory)");
+    }
+    clauseDd = ADD(mgr, node); // references node
+  }
+  return clauseDd;
+}
+
+BDD Counter::getClauseBdd(const vector<Int> &clause) const {
+  vector<std::pair<Int, Int>> levelLiterals; // (level of ddVar, literal)
+  for (Int literal : clause) {
+    Int ddVar = cnfVarToDdVarMap.at(util::getCnfVar(literal));
+    levelLiterals.push_back({Cudd_ReadPerm(mgr.getManager(), ddVar), literal});
+  }
+  std::sort(levelLiterals.begin(), levelLiterals.end(), std::greater<std::pair<Int, Int>>()); // bottom level first, so each disjunction adds one node on top
+
+  BDD clauseBdd = mgr.bddZero();
+  for (const std::pair<Int, Int> &levelLiteral : levelLiterals) {
+    Int literal = levelLiteral.second;
+    BDD literalBdd = mgr.bddVar(cnfVarToDdVarMap.at(util::getCnfVar(literal)));
+    clauseBdd |= util::isPositiveLiteral(literal) ? literalBdd : !literalBdd;
+  }
+  return clauseBdd;
+}
+
+BDD Counter::getClausesBdd(const vector<vector<Int>> &clauses, const vector<Int> &clauseIndices) const {
+  BDD conjunctionBdd = mgr.bddOne();
+  for (Int clauseIndex : clauseIndices) {
+    conjunctionBdd &= getClauseBdd(clauses.at(clauseIndex));
+    if (conjunctionBdd.IsZero()) break; // unsatisfiable
+  }
+  return conjunctionBdd;
+}
+
+ADD Counter::getClausesDd(const vector<vector<Int>> &clauses, const vector<Int> &clauseIndices) const {
+  if (clauseIndices.size() == 1) {
+    return getClauseDd(clauses.at(clauseIndices.front())); // no conversion needed
+  }
+  return convertIndicatorDd(getClausesBdd(clauses, clauseIndices).Add());
+}
+
+void Counter::rescale(ADD &dd) {
+  if (!extendedRange || semiring == Semiring::LOG_SUM_EXP) return; // log terminals have ample range
+
+  Float maxMagnitude = std::max(std::abs(diagram::getTerminalValue(dd.FindMax())), std::abs(diagram::getTerminalValue(dd.FindMin())));
+  if (maxMagnitude == 0 || !std::isfinite(maxMagnitude)) return;
+
+  int exponent;
+  std::frexp(maxMagnitude, &exponent);
+  if (std::abs(exponent) < RESCALING_MIN_EXPONENT) return; // rescaling costs a pass over dd
+
+  while (exponent != 0) { // steps keep powers of 2 within Float range
+    int step = std::max(std::min(exponent, 1000), -1000);
+    dd *= mgr.constant(std::ldexp(1.0, -step)); // exact
+    ddExponent += step;
+    exponent -= step;
+  }
+}
+
+void Counter::roundTerminals(ADD &dd) {
+  if (epsilon <= 0) return;
+
+  roundingBits = std::ceil(-std::log2(epsilon)); // relative rounding error is at most 2^-roundingBits <= epsilon
+  DdNode *node = Cudd_addMonadicApply(mgr.getManager(), roundTerminal, dd.getNode());
+  if (node == nullptr) showError("unable to round terminals of ADD (out of memory)");
+
+  if (node != dd.getNode()) { // some terminal was rounded
+    dd = ADD(mgr, node);
+    roundingCount++;
+  }
+}
+
+void Counter::normalize(ADD &dd) {
+  rescale(dd);
+  roundTerminals(dd);
+}
+
+Float Counter::getRelativeErrorBound() const {
+  return std::expm1(totalRoundingCount * std::log1p(std::ldexp(1.0, -roundingBits))); // (1 + 2^-roundingBits)^totalRoundingCount - 1
+}
+
+ExtendedFloat Counter::countConstDd(const ADD &dd) const {
+  Float value = diagram::countConstDdFloat(dd);
+  if (semiring == Semiring::LOG_SUM_EXP) { // natural log of count
+    if (value == NEGATIVE_INFINITY) return ExtendedFloat(0);
+
+    Float log2Value = value / std::log(2.0);
+    Float exponent = std::floor(log2Value);
+    return ExtendedFloat(std::exp2(log2Value - exponent), exponent);
+  }
+  return ExtendedFloat(value, ddExponent);
+}
+
+ADD Counter::applyDds(DD_AOP terminalOperator, const ADD &f, const ADD &g) const {
+  DdNode *node = Cudd_addApply(mgr.getManager(), terminalOperator, f.getNode(), g.getNode());
+  if (node == nullptr) showError("unable to apply operator to ADDs (out of memory)");
+  return ADD(mgr, node); // references node
+}
+
+template<typename S> void Counter::multiplyDdsIn(ADD &dd, const ADD &factor) const {
+  dd = applyDds(S::multiplyTerminals, dd, factor);
+}
+
+template<typename S> void Counter::abstractIn(ADD &dd, Int ddVar, const Map<Int, Float> &literalWeights) const {
+  Int cnfVar = ddVarToCnfVarMap.at(ddVar);
+  ADD positiveDd = dd.Compose(mgr.addOne(), ddVar); // cofactors do not depend on semiring
+  ADD negativeDd = dd.Compose(mgr.addZero(), ddVar);
+  multiplyDdsIn<S>(positiveDd, mgr.constant(S::getTerminal(literalWeights.at(cnfVar))));
+  multiplyDdsIn<S>(negativeDd, mgr.constant(S::getTerminal(literalWeights.at(-cnfVar))));
+
+  dd = applyDds(S::addTerminals, positiveDd, negativeDd);
+}
+
+template<typename S> void Counter::abstractCubeIn(ADD &dd, const Set<Int> &ddVars, const Cnf &cnf) {
+  for (Int ddVar : ddVars) {
+    abstractIn<S>(dd, ddVar, cnf.getLiteralWeights());
+    normalize(dd);
+  }
+}
+
+template<> void Counter::abstractCubeIn<SumProduct>(ADD &dd, const Set<Int> &ddVars, const Cnf &cnf) {
+  const Map<Int, Float> &literalWeights = cnf.getLiteralWeights();
+  ExtendedFloat scalar = 1; // accumulated from EQUAL and RESTRICTING vars
+  vector<ADD> summingDdVars; // UNIT and EQUAL vars
+  vector<Int> generalDdVars;
+  for (Int ddVar : ddVars) {
+    Int cnfVar = ddVarToCnfVarMap.at(ddVar);
+    switch (cnf.getVarWeightClass(cnfVar)) {
+      case WeightClass::UNIT: {
+        summingDdVars.push_back(mgr.addVar(ddVar));
+        break;
+      }
+      case WeightClass::EQUAL: {
+        summingDdVars.push_back(mgr.addVar(ddVar));
+        scalar *= literalWeights.at(cnfVar);
+        break;
+      }
+      case WeightClass::RESTRICTING: { // cofactor only shrinks dd
+        bool positive = literalWeights.at(-cnfVar) == 0;
+        dd = dd.Compose(positive ? mgr.addOne() : mgr.addZero(), ddVar);
+        scalar *= literalWeights.at(positive ? cnfVar : -cnfVar);
+        break;
+      }
+      default: {
+        generalDdVars.push_back(ddVar);
+      }
+    }
+  }
+
+  Int chunkSize = extendedRange ? RESCALING_MIN_EXPONENT : summingDdVars.size(); // each summed var at most doubles max magnitude
+  for (Int i = 0; i < summingDdVars.size(); i += chunkSize) { // sums out each chunk of vars in one pass
+    vector<ADD> chunkDdVars(summingDdVars.begin() + i, summingDdVars.begin() + std::min(i + chunkSize, Int(summingDdVars.size())));
+    dd = dd.ExistAbstract(mgr.computeCube(chunkDdVars));
+    rescale(dd); // before terminals overflow (if extendedRange)
+  }
+  for (Int ddVar : generalDdVars) {
+    abstractIn<SumProduct>(dd, ddVar, literalWeights);
+    normalize(dd);
+  }
+  if (scalar.toFloat() != 1) {
+    if (extendedRange) { // scalar may be out of Float range
+      dd *= mgr.constant(scalar.mantissa);
+      ddExponent += scalar.exponent;
+    }
+    else {
+      dd *= mgr.constant(scalar.toFloat());
+    }
+  }
+  normalize(dd);
+}
+
+Float Counter::getSemiringTerminal(Float weight) const {
+  switch (semiring) {
+    case Semiring::MAX_PRODUCT: {
+      return MaxProduct::getTerminal(weight);
+    }
+    case Semiring::LOG_SUM_EXP: {
+      return LogSumExp::getTerminal(weight);
+    }
+    case Semiring::MODULAR_SUM_PRODUCT: {
+      return ModularSumProduct::getTerminal(weight);
+    }
+    default: {
+      return SumProduct::getTerminal(weight);
+    }
+  }
+}
+
+ADD Counter::getOneDd() const {
+  return mgr.constant(getSemiringTerminal(1));
+}
+
+ADD Counter::getZeroDd() const {
+  return mgr.constant(getSemiringTerminal(0));
+}
+
+ADD Counter::convertIndicatorDd(const ADD &dd) const {
+  if (semiring != Semiring::LOG_SUM_EXP) return dd; // 0 and 1 already
+
+  DdNode *node = Cudd_addMonadicApply(mgr.getManager(), LogSumExp::convertIndicatorTerminal, dd.getNode());
+  if (node == nullptr) showError("unable to convert terminals of ADD (out of memory)");
+  return ADD(mgr, node);
+}
+
+void Counter::multiplyDds(ADD &dd, const ADD &factor) const {
+  switch (semiring) {
+    case Semiring::MAX_PRODUCT: {
+      multiplyDdsIn<MaxProduct>(dd, factor);
+      break;
+    }
+    case Semiring::LOG_SUM_EXP: {
+      multiplyDdsIn<LogSumExp>(dd, factor);
+      break;
+    }
+    case Semiring::MODULAR_SUM_PRODUCT: {
+      multiplyDdsIn<ModularSumProduct>(dd, factor);
+      break;
+    }
+    default: {
+      multiplyDdsIn<SumProduct>(dd, factor);
+    }
+  }
+}
+
+bool Counter::isZeroDd(const ADD &dd) const {
+  return dd.getNode() == getZeroDd().getNode();
+}
+
+void Counter::multiplyConstant(Float &constantFactor, Float constant) {
+  constantFactor *= constant;
+  if (extendedRange && constantFactor != 0) { // product of many constants may leave Float range
+    int exponent;
+    constantFactor = std::frexp(constantFactor, &exponent);
+    ddExponent += exponent;
+  }
+}
+
+bool Counter::extractConstant(Float &constantFactor, const ADD &dd) {
+  if (!Cudd_IsConstant(dd.getNode()) || isZeroDd(dd)) return false;
+  if (semiring != Semiring::SUM_PRODUCT && semiring != Semiring::MAX_PRODUCT) return false; // ADD product is no Float product
+
+  multiplyConstant(constantFactor, diagram::getTerminalValue(dd));
+  return true;
+}
+
+void Counter::foldConstant(ADD &dd, Float &constantFactor) {
+  if (constantFactor == 1) return;
+
+  multiplyDds(dd, mgr.constant(constantFactor));
+  normalize(dd);
+  constantFactor = 1;
+}
+
+ADD Counter::multiplyScheduled(vector<ADD> &dds, const Set<Int> &projectingDdVars, const Cnf &cnf) {
+  vector<ADD> operandDds; // operandIndex |-> ADD; product of pair takes index of first operand
+  operandDds.swap(dds); // releases operands once multiplied
+  vector<Set<Int>> supports(operandDds.size());
+  vector<Int> nodeCounts(operandDds.size());
+  Map<Int, Set<Int>> ddVarOperands; // ddVar |-> indices of live operands with ddVar in support
+  std::set<std::pair<Int, Int>> sizedOperands; // (nodeCount, operandIndex) of live operands
+  Set<Int> unabstractedDdVars = projectingDdVars;
+
+  auto registerOperand = [&](Int operandIndex) {
+    supports.at(operandIndex) = util::getSupport(operandDds.at(operandIndex));
+    nodeCounts.at(operandIndex) = operandDds.at(operandIndex).nodeCount();
+    for (Int ddVar : supports.at(operandIndex)) ddVarOperands[ddVar].insert(operandIndex);
+    sizedOperands.insert({nodeCounts.at(operandIndex), operandIndex});
+  };
+  auto unregisterOperand = [&](Int operandIndex) {
+    for (Int ddVar : supports.at(operandIndex)) ddVarOperands.at(ddVar).erase(operandIndex);
+    sizedOperands.erase({nodeCounts.at(operandIndex), operandIndex});
+  };
+  auto refreshOperand = [&](Int operandIndex) { // abstracts projecting ddVars in no other operand
+    unregisterOperand(operandIndex);
+    Set<Int> localDdVars;
+    for (Int ddVar : util::getSupport(operandDds.at(operandIndex))) {
+      if (util::isFound(ddVar, unabstractedDdVars) && ddVarOperands[ddVar].empty()) localDdVars.insert(ddVar);
+    }
+    if (!localDdVars.empty()) {
+      abstractCube(operandDds.at(operandIndex), localDdVars, cnf);
+      for (Int ddVar : localDdVars) unabstractedDdVars.erase(ddVar);
+    }
+    registerOperand(operandIndex);
+  };
+
+  for (Int operandIndex = 0; operandIndex < operandDds.size(); operandIndex++) {
+    if (isZeroDd(operandDds.at(operandIndex))) return getZeroDd();
+    registerOperand(operandIndex);
+  }
+  for (Int operandIndex = 0; operandIndex < operandDds.size(); operandIndex++) {
+    refreshOperand(operandIndex);
+  }
+
+  while (sizedOperands.size() > 1) {
+    Int operandIndex = sizedOperands.begin()->second; // fewest nodes
+    Int operandIndex2 = std::next(sizedOperands.begin())->second;
+    if (multiplicationSchedule == MultiplicationSchedule::MAX_OVERLAP) {
+      Map<Int, Int> overlaps; // operandIndex |-> shared ddVar count
+      for (Int ddVar : supports.at(operandIndex)) {
+        for (Int otherOperandIndex : ddVarOperands.at(ddVar)) {
+          if (otherOperandIndex != operandIndex) overlaps[otherOperandIndex]++;
+        }
+      }
+      for (const auto &kv : overlaps) { // ties go to fewer nodes, then to lower index
+        Int overlap2 = overlaps.count(operandIndex2) ? overlaps.at(operandIndex2) : 0;
+        if (std::make_tuple(-kv.second, nodeCounts.at(kv.first), kv.first) < std::make_tuple(-overlap2, nodeCounts.at(operandIndex2), operandIndex2)) {
+          operandIndex2 = kv.first;
+        }
+      }
+    }
+
+    unregisterOperand(operandIndex2);
+    multiplyDds(operandDds.at(operandIndex), operandDds.at(operandIndex2));
+    operandDds.at(operandIndex2) = ADD();
+    normalize(operandDds.at(operandIndex));
+    if (isZeroDd(operandDds.at(operandIndex))) return getZeroDd(); // count is 0 whatever remains
+    refreshOperand(operandIndex);
+  }
+
+  ADD dd = sizedOperands.empty() ? getOneDd() : operandDds.at(sizedOperands.begin()->second);
+  abstractCube(dd, unabstractedDdVars, cnf); // e.g. vars in no operand, which still have weights
+  return dd;
+}
+
+void Counter::abstractCube(ADD &dd, const Set<Int> &ddVars, const Cnf &cnf) {
+  switch (semiring) {
+    case Semiring::MAX_PRODUCT: {
+      abstractCubeIn<MaxProduct>(dd, ddVars, cnf);
+      break;
+    }
+    case Semiring::LOG_SUM_EXP: {
+      abstractCubeIn<LogSumExp>(dd, ddVars, cnf);
+      break;
+    }
+    case Semiring::MODULAR_SUM_PRODUCT: {
+      abstractCubeIn<ModularSumProduct>(dd, ddVars, cnf);
+      break;
+    }
+    default: {
+      abstractCubeIn<SumProduct>(dd, ddVars, cnf);
+    }
+  }
+}
+
+ADD Counter::renameCnfVars(const ADD &dd, const vector<Int> &oldCnfVars, const vector<Int> &newCnfVars) const {
+  if (oldCnfVars == newCnfVars) return dd;
+
+  vector<int> permutation; // ddVar |-> ddVar
+  for (Int ddVar = 0; ddVar < mgr.ReadSize(); ddVar++) {
+    permutation.push_back(ddVar);
+  }
+  for (Int i = 0; i < oldCnfVars.size(); i++) {
+    permutation.at(cnfVarToDdVarMap.at(oldCnfVars.at(i))) = cnfVarToDdVarMap.at(newCnfVars.at(i));
+  }
+  return dd.Permute(permutation.data());
+}
+
+SubformulaKey Counter::getClauseKey(const vector<Int> &clause) const {
+  SubformulaHasher hasher;
+  hasher.addClause(clause);
+  return hasher.getKey();
+}
+
+void Counter::sumDdVars(ADD &dd, const Set<Int> &ddVars) {
+  if (ddVars.empty()) return;
+
+  vector<ADD> cubeDdVars;
+  for (Int ddVar : ddVars) cubeDdVars.push_back(mgr.addVar(ddVar));
+  dd = dd.ExistAbstract(mgr.computeCube(cubeDdVars));
+}
+
+void Counter::multiplyLiteralWeights(ADD &dd, const Set<Int> &ddVars, const Map<Int, Float> &literalWeights) {
+  for (Int ddVar : ddVars) {
+    Int cnfVar = ddVarToCnfVarMap.at(ddVar);
+    dd *= mgr.addVar(ddVar).Ite(mgr.constant(literalWeights.at(cnfVar)), mgr.constant(literalWeights.at(-cnfVar)));
+  }
+}
+
+void Counter::addMarginals(Map<Int, Float> &marginals, const ADD &dd, const vector<Int> &ddVars, Float factor, const Cnf &cnf) {
+  if (ddVars.size() == 1) {
+    Int ddVar = ddVars.front();
+    Int cnfVar = ddVarToCnfVarMap.at(ddVar);
+    marginals[cnfVar] = diagram::countConstDdFloat(dd.Compose(mgr.addOne(), ddVar)) * factor;
+    marginals[-cnfVar] = diagram::countConstDdFloat(dd.Compose(mgr.addZero(), ddVar)) * factor;
+    return;
+  }
+
+  auto middle = ddVars.begin() + ddVars.size() / 2; // each var is abstracted in log(ddVars.size()) ADDs
+  vector<Int> firstDdVars(ddVars.begin(), middle);
+  vector<Int> secondDdVars(middle, ddVars.end());
+
+  ADD firstDd = dd;
+  abstractCube(firstDd, Set<Int>(secondDdVars.begin(), secondDdVars.end()), cnf);
+  addMarginals(marginals, firstDd, firstDdVars, factor, cnf);
+
+  ADD secondDd = dd;
+  abstractCube(secondDd, Set<Int>(firstDdVars.begin(), firstDdVars.end()), cnf);
+  addMarginals(marginals, secondDd, secondDdVars, factor, cnf);
+}
+
+void Counter::startJoinTree(const Cnf &cnf, Int terminalCount) {
+  delete joinTree; // frees all nodes of previous join tree
+  joinTree = new JoinTree(cnf.getDeclaredVarCount(), terminalCount);
+}
+
+void Counter::printJoinTree(const Cnf &cnf) const {
+  JoinTree *joinRootTree = joinRoot->getJoinTree();
+  cout << PROBLEM_WORD << " " << JT_WORD << " " << cnf.getDeclaredVarCount() << " " << joinRootTree->getTerminalCount() << " " << joinRootTree->getNodeCount() << "\n";
+  joinRoot->printSubtree();
+}
+
+void Counter::setJoinTree(const Cnf &cnf) {
+  if (cnf.getClauses().empty()) { // empty cnf
+    // showWarning("cnf is empty"); // different warning for empty clause
+    startJoinTree(cnf, 0);
+    joinRoot = joinTree->getJoinNode(joinTree->addNonterminal(vector<Int>()));
+    return;
+  }
+
+  Int i = cnf.getEmptyClauseIndex();
+  if (i != DUMMY_MIN_INT) { // empty clause found
+    showWarning("clause " + to_string(i + 1) + " of cnf is empty (1-indexing); generating dummy join tree");
+    startJoinTree(cnf, 0);
+    joinRoot = joinTree->getJoinNode(joinTree->addNonterminal(vector<Int>()));
+  }
+  else {
+    constructJoinTree(cnf);
+  }
+}
+
+void Counter::fillSubtreeKeys(JoinNode *joinRoot, const Cnf &cnf, const Map<Int, Float> &literalWeights) {
+  for (JoinNode *joinNode : joinRoot->getPostorder()) { // child keys before parent keys
+    SubformulaHasher hasher;
+    for (JoinNode *child : joinNode->getChildren()) {
+      if (child->isTerminal()) {
+        hasher.addClause(cnf.getClauses().at(child->getNodeIndex()));
+      }
+      else {
+        hasher.addSubformula(subtreeKeys.at(child->getNodeIndex()));
+      }
+    }
+    Set<Int> projectingCnfVars;
+    for (Int cnfVar : joinNode->getProjectableCnfVars()) {
+      if (!util::isFound(cnfVar, queryCnfVars)) projectingCnfVars.insert(cnfVar); // query vars stay on boundary
+    }
+    hasher.addProjectedCnfVars(projectingCnfVars, literalWeights);
+
+    SubformulaKey key = hasher.getKey();
+    subtreeKeys[joinNode->getNodeIndex()] = key;
+    subformulaCache.countOccurrence(key);
+  }
+}
+
+void Counter::fillSubtreeLiveDdCounts(JoinNode *joinRoot) {
+  for (JoinNode *joinNode : joinRoot->getPostorder()) {
+    Int liveDdCount = 1; // product
+    Int heldDdCount = 0; // finished children, kept until last one finishes (unless multiplicationSchedule is LEFT_TO_RIGHT)
+    vector<JoinNode *> children = getExecutionChildren(joinNode);
+    for (Int childPosition = 0; childPosition < children.size(); childPosition++) {
+      JoinNode *child = children.at(childPosition);
+      if (child->isTerminal() && childPosition > 0 && children.at(childPosition - 1)->isTerminal()) continue; // conjoined with previous sibling
+      Int productCount = childPosition == 0 ? 0 : 1; // trivial before first child
+      if (multiplicationSchedule != MultiplicationSchedule::LEFT_TO_RIGHT) productCount = heldDdCount;
+      liveDdCount = std::max(liveDdCount, productCount + getSubtreeLiveDdCount(child));
+      heldDdCount++;
+    }
+    if (multiplicationSchedule != MultiplicationSchedule::LEFT_TO_RIGHT) liveDdCount = std::max(liveDdCount, heldDdCount);
+    subtreeLiveDdCounts[joinNode->getNodeIndex()] = liveDdCount;
+  }
+}
+
+Int Counter::getSubtreeLiveDdCount(JoinNode *joinNode) const {
+  return joinNode->isTerminal() ? 1 : subtreeLiveDdCounts.at(joinNode->getNodeIndex());
+}
+
+vector<JoinNode *> Counter::getExecutionChildren(JoinNode *joinNode) const {
+  vector<JoinNode *> children;
+  for (JoinNode *child : joinNode->getChildren()) {
+    children.push_back(child);
+  }
+  std::stable_sort(children.begin(), children.end(), [this](JoinNode *child, JoinNode *child2) { return getSubtreeLiveDdCount(child) > getSubtreeLiveDdCount(child2); }); // like register allocation of expression trees
+  return children;
+}
+
+void Counter::addSubtreeProjectableCnfVars(Set<Int> &projectedCnfVars, JoinNode *joinRoot) const {
+  for (JoinNode *joinNode : joinRoot->getPostorder()) {
+    util::unionize(projectedCnfVars, joinNode->getProjectableCnfVars());
+  }
+}
+
+bool Counter::pushSubtreeFrame(JoinNode *joinNode, ADD &cachedDd) {
+  SubtreeFrame frame;
+  frame.nodeIndex = joinNode->getNodeIndex();
+  frame.finishedChildCount = 0;
+  frame.dd = getOneDd();
+  frame.key = nullptr;
+  frame.startDdExponent = ddExponent;
+  frame.startRoundingCount = roundingCount;
+  frame.constantFactor = 1;
+  if (subformulaCaching) {
+    frame.key = &subtreeKeys.at(frame.nodeIndex);
+    if (!subformulaCache.isRecurrent(*frame.key)) {
+      frame.key = nullptr;
+    }
+  }
+
+  auto restoredFrame = restoredFrameIndices.find(frame.nodeIndex);
+  if (restoredFrame != restoredFrameIndices.end()) { // skips children finished before checkpoint
+    frame.dd = restoredCheckpoint.dds.at(restoredFrame->second);
+    frame.finishedChildCount = restoredCheckpoint.ddPositions.at(restoredFrame->second);
+    restoredCheckpoint.dds.at(restoredFrame->second) = getOneDd();
+    restoredFrameIndices.erase(restoredFrame);
+    if (extendedRange || epsilon > 0) frame.key = nullptr; // scale and error of restored product are mixed into ddExponent and roundingCount
+  }
+  else if (frame.key != nullptr) {
+    Int cachedDdExponent;
+    Int cachedRoundingCount;
+    vector<Int> cachedBoundaryCnfVars;
+    if (subformulaCache.lookUp(cachedDd, cachedDdExponent, cachedRoundingCount, cachedBoundaryCnfVars, *frame.key)) {
+      cachedDd = renameCnfVars(cachedDd, cachedBoundaryCnfVars, frame.key->boundaryCnfVars);
+      ddExponent += cachedDdExponent;
+      roundingCount += cachedRoundingCount; // reused ADD carries its error again
+      return false;
+    }
+  }
+
+  frame.children = getExecutionChildren(joinNode);
+  subtreeFrames.push_back(frame);
+  return true;
+}
+
+ADD Counter::countSubtree(JoinNode *joinRoot, const Cnf &cnf) {
+  ADD dd; // of latest finished child
+  Float ddConstantFactor = 1; // of latest finished child, kept out of dd
+  if (joinRoot->isTerminal()) {
+    if (localDdVars) {
+      for (Int literal : cnf.getClauses().at(joinRoot->getNodeIndex())) assignDdVar(util::getCnfVar(literal));
+    }
+    return getClauseDd(cnf.getClauses().at(joinRoot->getNodeIndex()));
+  }
+  if (!pushSubtreeFrame(joinRoot, dd)) {
+    return dd;
+  }
+
+  while (true) {
+    SubtreeFrame &frame = subtreeFrames.back();
+    Int finishingChildCount = 1; // children whose product is dd
+    if (frame.finishedChildCount < frame.children.size() && nextJoinRoot == nullptr) {
+      JoinNode *child = frame.children.at(frame.finishedChildCount);
+      if (child->isTerminal()) { // conjoins consecutive terminal siblings as BDDs
+        vector<Int> clauseIndices;
+        for (Int childIndex = frame.finishedChildCount; childIndex < frame.children.size() && frame.children.at(childIndex)->isTerminal(); childIndex++) {
+          clauseIndices.push_back(frame.children.at(childIndex)->getNodeIndex());
+        }
+        if (localDdVars) {
+          for (Int clauseIndex : clauseIndices) {
+            for (Int literal : cnf.getClauses().at(clauseIndex)) assignDdVar(util::getCnfVar(literal));
+          }
+        }
+        dd = getClausesDd(cnf.getClauses(), clauseIndices);
+        finishingChildCount = clauseIndices.size();
+      }
+      else if (pushSubtreeFrame(child, dd)) { // invalidates frame
+        continue;
+      }
+      ddConstantFactor = 1; // cached ADDs include their constants
+    }
+    else { // finishes nonterminal
+      if (nextJoinRoot == nullptr) {
+        vector<ADD> operandDds; // unless multiplicationSchedule is LEFT_TO_RIGHT
+        for (Int spillId : frame.spilledDdIds) {
+          if (multiplicationSchedule == MultiplicationSchedule::LEFT_TO_RIGHT) {
+            multiplyDds(frame.dd, spillManager.reload(spillId, mgr));
+          }
+          else {
+            operandDds.push_back(spillManager.reload(spillId, mgr));
+          }
+        }
+        Span<Int> projectableCnfVars = joinRoot->getJoinTree()->getJoinNode(frame.nodeIndex)->getProjectableCnfVars();
+        Set<Int> projectingDdVars;
+        for (Int cnfVar : projectableCnfVars) {
+          if (!util::isFound(cnfVar, queryCnfVars)) projectingDdVars.insert(localDdVars ? assignDdVar(cnfVar) : cnfVarToDdVarMap.at(cnfVar)); // var in no child still has weight
+        }
+        if (multiplicationSchedule == MultiplicationSchedule::LEFT_TO_RIGHT) {
+          abstractCube(frame.dd, projectingDdVars, cnf);
+        }
+        else {
+          operandDds.push_back(frame.dd);
+          operandDds.insert(operandDds.end(), frame.childDds.begin(), frame.childDds.end());
+          frame.childDds.clear();
+          frame.dd = multiplyScheduled(operandDds, projectingDdVars, cnf);
+        }
+        if (localDdVars) {
+          for (Int cnfVar : projectableCnfVars) releaseDdVar(cnfVar);
+        }
+        if (frame.key != nullptr) {
+          foldConstant(frame.dd, frame.constantFactor); // reused result needs constants of its subtree
+          subformulaCache.insert(frame.dd, ddExponent - frame.startDdExponent, roundingCount - frame.startRoundingCount, *frame.key);
+        }
+        if (isSpeculating()) {
+          remainingJoinTreeCost -= joinNodeCosts.at(frame.nodeIndex);
+        }
+      }
+      dd = frame.dd;
+      ddConstantFactor = frame.constantFactor;
+      subtreeFrames.pop_back();
+      if (subtreeFrames.empty()) {
+        foldConstant(dd, ddConstantFactor);
+        return dd;
+      }
+      if (nextJoinRoot != nullptr) continue; // unwinds aborted count
+    }
+
+    SubtreeFrame &parentFrame = subtreeFrames.back();
+    if (isZeroDd(dd)) { // count is 0 whatever remains
+      subtreeFrames.clear();
+      return dd;
+    }
+    multiplyConstant(parentFrame.constantFactor, ddConstantFactor);
+    if (!extractConstant(parentFrame.constantFactor, dd)) {
+      if (multiplicationSchedule != MultiplicationSchedule::LEFT_TO_RIGHT) {
+        parentFrame.childDds.push_back(dd); // multiplied once siblings are finished
+      }
+      else {
+        multiplyDds(parentFrame.dd, dd);
+        normalize(parentFrame.dd);
+        if (isZeroDd(parentFrame.dd)) {
+          subtreeFrames.clear();
+          return getZeroDd();
+        }
+      }
+    }
+    dd = ADD(); // releases child ADD before its siblings are counted (unless parentFrame.childDds holds it)
+    parentFrame.finishedChildCount += finishingChildCount;
+    if (spillManager.isUnderPressure(mgr)) spillSubtreeFrames();
+    if (isCheckpointDue()) saveJoinTreeCheckpoint();
+    if (isSpeculating()) isRestartDue(cnf); // writes nextJoinRoot
+  }
+}
+
+ADD Counter::countJoinTreeDd(const Cnf &cnf) {
+  ADD dd;
+  Int restartCount = 0;
+  while (true) {
+    subtreeLiveDdCounts.clear();
+    fillSubtreeLiveDdCounts(joinRoot);
+
+    Hasher hasher;
+    addJoinTreeHashes(hasher, joinRoot);
+    HashPair joinTreeHashes = hasher.getHashes();
+    startCheckpointing(cnf, "join tree " + to_string(joinTreeHashes.first) + " " + to_string(joinTreeHashes.second));
+
+    if (localDdVars) {
+      startLocalDdVars(cnf);
+    }
+    else {
+      orderDdVars(cnf);
+    }
+
+    if (subformulaCaching) {
+      subformulaCache = SubformulaCache(); // entries depend on ddVar ordering
+      subtreeKeys.clear();
+      fillSubtreeKeys(joinRoot, cnf, cnf.getLiteralWeights());
+    }
+
+    if (isSpeculating()) {
+      joinNodeCosts.clear();
+      addJoinNodeCosts(joinNodeCosts, joinRoot, cnf);
+      remainingJoinTreeCost = getJoinTreeCost(joinNodeCosts);
+    }
+
+    if (resuming) {
+      for (Int ddIndex = 0; ddIndex < restoredCheckpoint.dds.size(); ddIndex++) {
+        restoredFrameIndices[restoredCheckpoint.ddTags.at(ddIndex)] = ddIndex;
+      }
+    }
+    startSpilling();
+    dd = countSubtree(joinRoot, cnf);
+    finishSpilling();
+
+    if (nextJoinRoot == nullptr) break;
+
+    restartCount++;
+    printComment("Restarting count on join tree " + to_string(joinTreeCount) + " (estimated cost " + to_string(getJoinTreeCost(joinNodeCosts)) + " before restart)", 1);
+    joinRoot = nextJoinRoot;
+    nextJoinRoot = nullptr;
+    finishCheckpointing(); // checkpoint of abandoned join tree is useless
+  }
+
+  if (isSpeculating() && verbosityLevel >= 1) {
+    util::printRow("joinTreeRestarts", restartCount);
+  }
+
+  if (subformulaCaching && verbosityLevel >= 1) {
+    subformulaCache.printStats();
+  }
+  if (verbosityLevel >= 1) {
+    util::printRow("maxLiveAddCount", getSubtreeLiveDdCount(joinRoot)); // predicted for multiplicationSchedule
+    if (localDdVars) {
+      util::printRow("addVarCount", mgr.ReadSize());
+      util::printRow("maxLiveAddVarCount", maxLiveDdVarCount);
+      util::printRow("addVarCompactionCount", ddVarCompactionCount);
+    }
+    util::printRow("peakLiveNodeCount", mgr.ReadPeakLiveNodeCount());
+  }
+
+  return dd;
+}
+
+ExtendedFloat Counter::countJoinTree(const Cnf &cnf) {
+  Int i = cnf.getEmptyClauseIndex();
+  if (i != DUMMY_MIN_INT) { // empty clause found
+    showWarning("clause " + to_string(i + 1) + " of cnf is empty (1-indexing)");
+    return 0;
+  }
+  else {
+    ADD dd = countJoinTreeDd(cnf);
+
+    Set<Int> projectedCnfVars;
+    addSubtreeProjectableCnfVars(projectedCnfVars, joinRoot);
+    ExtendedFloat modelCount = util::adjustModelCount(countConstDd(dd), projectedCnfVars, cnf.getLiteralWeights());
+    return modelCount;
+  }
 }
 
-void diagram::printMaxDdVarCount(Int maxDdVarCount) {
-  util::printRow("maxAddVarCount", maxDdVarCount);
+ExtendedFloat Counter::getModelCount(const Cnf &cnf) {
+  Int i = cnf.getEmptyClauseIndex();
+  if (i != DUMMY_MIN_INT) { // empty clause found
+    showWarning("clause " + to_string(i + 1) + " of cnf is empty (1-indexing)");
+    return 0;
+  }
+  else {
+    ExtendedFloat modelCount = computeModelCount(cnf);
+    totalRoundingCount += roundingCount;
+    finishCheckpointing();
+    return modelCount;
+  }
 }
 
-/* classes ********************************************************************/
+ExtendedFloat Counter::getCachedModelCount(const Cnf &cnf, const string &cnfFilePath) {
+  if (resultCacheDir == DUMMY_STR || epsilon > 0 || semiring != Semiring::SUM_PRODUCT) { // approximate counts and MPE values are not cached
+    return getModelCount(cnf);
+  }
 
-/* class Counter **************************************************************/
+  TimePoint countingStartTime = util::getTimePoint();
+  ResultCache resultCache(resultCacheDir, resultCacheMegabytes);
+  HashPair hashes = ResultCache::getCnfHashes(cnf);
 
-WeightFormat Counter::weightFormat;
+  ExtendedFloat modelCount;
+  if (resultCache.lookUp(modelCount, hashes)) {
+    return modelCount;
+  }
 
-void Counter::handleSignals(int signal) {
-  cout << "\n";
-  util::printDuration(startTime);
-  cout << "\n";
+  if (resultCachingComponents && countingComponents && cnf.getEmptyClauseIndex() == DUMMY_MIN_INT) {
+    vector<Cnf> components = cnf.getComponents();
+    if (verbosityLevel >= 1) util::printRow("componentCount", components.size());
+
+    modelCount = 1;
+    for (const Cnf &component : components) {
+      HashPair componentHashes = ResultCache::getCnfHashes(component);
+      ExtendedFloat componentModelCount;
+      if (!resultCache.lookUp(componentModelCount, componentHashes)) {
+        TimePoint componentStartTime = util::getTimePoint();
+        componentModelCount = getModelCount(component);
+        resultCache.insert(componentModelCount, componentHashes, cnfFilePath + " (component)", util::getSeconds(componentStartTime));
+      }
+      modelCount *= componentModelCount;
+    }
+    modelCount = util::adjustModelCount(modelCount, cnf.getApparentVars(), cnf.getLiteralWeights()); // vars in no clause
+  }
+  else {
+    modelCount = getModelCount(cnf);
+  }
 
-  util::printSolutionLine(weightFormat, 0, 0, 0);
-  showError("received system signal " + to_string(signal) + "; printed dummy model count");
+  resultCache.insert(modelCount, hashes, cnfFilePath, util::getSeconds(countingStartTime));
+  resultCache.evict();
+  return modelCount;
 }
 
-void Counter::writeDotFile(ADD &dd, const string &dotFileDir) {
-  writeDd(mgr, dd, dotFileDir + "dd" + to_string(dotFileIndex) + ".dot");
-  dotFileIndex++;
-}
+string Counter::getExactModelCount(const Cnf &cnf) {
+  Int i = cnf.getEmptyClauseIndex();
+  if (i != DUMMY_MIN_INT) { // empty clause found
+    showWarning("clause " + to_string(i + 1) + " of cnf is empty (1-indexing)");
+    return "0";
+  }
 
-const vector<Int> &Counter::getDdVarOrdering() const {
-  return ddVarToCnfVarMap;
-}
+  orderDdVars(cnf);
 
-void Counter::orderDdVars(const Cnf &cnf) {
-  ddVarToCnfVarMap = cnf.getVarOrdering(ddVarOrderingHeuristic, inverseDdVarOrdering);
-  for (Int ddVar = 0; ddVar < ddVarToCnfVarMap.size(); ddVar++) {
-    Int cnfVar = ddVarToCnfVarMap.at(ddVar);
-    cnfVarToDdVarMap[cnfVar] = ddVar;
-    mgr.addVar(ddVar); // creates ddVar-th ADD var
+  vector<Int> clauseIndices;
+  for (Int clauseIndex = 0; clauseIndex < cnf.getClauses().size(); clauseIndex++) {
+    clauseIndices.push_back(clauseIndex);
   }
-}
+  BDD cnfBdd = getClausesBdd(cnf.getClauses(), clauseIndices);
 
-ADD Counter::getClauseDd(const vector<Int> &clause) const {
-  ADD clauseDd = mgr.addZero();
-  for (Int literal : clause) {
-    Int ddVar = cnfVarToDdVarMap.at(util::getCnfVar(literal));
-    ADD literalDd = mgr.addVar(ddVar);
-    if (!util::isPositiveLiteral(literal)) literalDd = ~literalDd;
-    clauseDd |= literalDd;
-  }
-  return clauseDd;
+  Int totalVarCount = cnf.getLiteralWeights().size() / 2; // including vars in no clause
+  return diagram::countBddMintermsExactly(cnfBdd, totalVarCount);
 }
 
-void Counter::abstract(ADD &dd, Int ddVar, const Map<Int, Float> &literalWeights) {
-  Int cnfVar = ddVarToCnfVarMap.at(ddVar);
-  ADD positiveWeight = mgr.constant(literalWeights.at(cnfVar));
-  ADD negativeWeight = mgr.constant(literalWeights.at(-cnfVar));
+void Counter::prepareModularRuns(const Cnf &) {} // each forked run builds its own diagrams
 
-  dd = positiveWeight * dd.Compose(mgr.addOne(), ddVar) + negativeWeight * dd.Compose(mgr.addZero(), ddVar);
+ExtendedFloat Counter::countModularly(const Cnf &integerWeightCnf) {
+  return getModelCount(integerWeightCnf);
 }
 
-void Counter::abstractCube(ADD &dd, const Set<Int> &ddVars, const Map<Int, Float> &literalWeights) {
-  for (Int ddVar :ddVars) {
-    abstract(dd, ddVar, literalWeights);
+std::pair<pid_t, int> Counter::startModularRun(const Cnf &integerWeightCnf, Int modulus) {
+  int residuePipe[2];
+  if (pipe2(residuePipe, O_CLOEXEC) != 0) {
+    showError("unable to create pipe for modular run");
   }
-}
 
-void Counter::printJoinTree(const Cnf &cnf) const {
-  cout << PROBLEM_WORD << " " << JT_WORD << " " << cnf.getDeclaredVarCount() << " " << joinRoot->getTerminalCount() << " " << joinRoot->getNodeCount() << "\n";
-  joinRoot->printSubtree();
+  cout << std::flush; // child must not repeat buffered output
+  pid_t pid = fork();
+  if (pid < 0) {
+    showError("unable to fork modular run");
+  }
+  if (pid == 0) { // child: globals are private copies
+    close(residuePipe[0]);
+    int exitStatus = 1;
+    try {
+      semiring = Semiring::MODULAR_SUM_PRODUCT;
+      terminalModulus = modulus;
+      extendedRange = false; // rescaling and rounding would break residues
+      epsilon = 0;
+      verbosityLevel = 0; // concurrent runs would interleave stats
+      checkpointDir = DUMMY_STR;
+      Int residue = util::getResidue(countModularly(integerWeightCnf).toFloat(), modulus);
+      if (write(residuePipe[1], &residue, sizeof(residue)) == sizeof(residue)) exitStatus = 0;
+    }
+    catch (const MyError &) {} // already printed
+    cout << std::flush;
+    _exit(exitStatus);
+  }
+
+  close(residuePipe[1]);
+  return {pid, residuePipe[0]};
 }
 
-void Counter::setJoinTree(const Cnf &cnf) {
-  if (cnf.getClauses().empty()) { // empty cnf
-    // showWarning("cnf is empty"); // different warning for empty clause
-    joinRoot = new JoinNonterminal(vector<JoinNode *>());
-    return;
+Int Counter::finishModularRun(const std::pair<pid_t, int> &modularRun) {
+  Int residue;
+  ssize_t byteCount;
+  do {
+    byteCount = read(modularRun.second, &residue, sizeof(residue));
+  } while (byteCount < 0 && errno == EINTR);
+  close(modularRun.second);
+
+  int status;
+  while (waitpid(modularRun.first, &status, 0) < 0 && errno == EINTR) {}
+  if (byteCount != sizeof(residue) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    showError("modular run " + to_string(modularRun.first) + " failed");
   }
+  return residue;
+}
 
+string Counter::getExactWeightedModelCount(const Cnf &cnf) {
   Int i = cnf.getEmptyClauseIndex();
   if (i != DUMMY_MIN_INT) { // empty clause found
-    showWarning("clause " + to_string(i + 1) + " of cnf is empty (1-indexing); generating dummy join tree");
-    joinRoot = new JoinNonterminal(vector<JoinNode *>());
+    showWarning("clause " + to_string(i + 1) + " of cnf is empty (1-indexing)");
+    return "0";
   }
-  else {
-    constructJoinTree(cnf);
+  for (const auto &literalWeight : cnf.getLiteralWeights()) {
+    if (literalWeight.second < 0) {
+      showError("exact weighted counting needs nonnegative weights");
+    }
+  }
+  if (checkpointDir != DUMMY_STR) {
+    showWarning("exact weighted counting has no checkpoints");
+  }
+
+  TimePoint countingStartTime = util::getTimePoint();
+  Int decimalExponent;
+  Cnf integerWeightCnf = cnf.getIntegerWeightCnf(decimalExponent);
+
+  /* enough moduli for product to exceed integer-weighted count, which is at most product of var weight sums: */
+  Float countBitCount = 1;
+  const Map<Int, Float> &integerWeights = integerWeightCnf.getLiteralWeights();
+  for (Int var = 1; var <= integerWeightCnf.getDeclaredVarCount(); var++) {
+    countBitCount += std::log2(std::max(integerWeights.at(var) + integerWeights.at(-var), 1.0));
+  }
+  Int moduliCount = std::ceil(countBitCount / (std::log2(MAX_MODULUS) - 1)); // each prime exceeds 2^30
+  vector<Int> moduli = util::getLargestPrimes(MAX_MODULUS, moduliCount);
+
+  prepareModularRuns(integerWeightCnf);
+  Int maxConcurrentRunCount = std::max(std::thread::hardware_concurrency(), 1u);
+  vector<Int> residues;
+  for (Int firstIndex = 0; firstIndex < moduli.size(); firstIndex += maxConcurrentRunCount) {
+    vector<std::pair<pid_t, int>> modularRuns;
+    for (Int index = firstIndex; index < std::min(firstIndex + maxConcurrentRunCount, Int(moduli.size())); index++) {
+      modularRuns.push_back(startModularRun(integerWeightCnf, moduli.at(index)));
+    }
+    for (const std::pair<pid_t, int> &modularRun : modularRuns) {
+      residues.push_back(finishModularRun(modularRun));
+    }
+  }
+
+  if (verbosityLevel >= 1) {
+    util::printRow("decimalWeightExponent", decimalExponent);
+    util::printRow("modularRunCount", moduli.size());
+    util::printRow("maxConcurrentRunCount", maxConcurrentRunCount);
+    util::printRow("modularCountingSeconds", util::getSeconds(countingStartTime));
   }
+  return util::reconstructDecimal(residues, moduli, decimalExponent);
 }
 
-ADD Counter::countSubtree(JoinNode *joinNode, const Cnf &cnf, Set<Int> &projectedCnfVars) {
-  if (joinNode->isTerminal()) {
-    return getClauseDd(cnf.getClauses().at(joinNode->getNodeIndex()));
+Map<Int, Float> Counter::computeMarginals(const Cnf &cnf, Float &modelCount) {
+  const Map<Int, Float> &literalWeights = cnf.getLiteralWeights();
+  Int totalVarCount = literalWeights.size() / 2; // including vars in no clause
+  Map<Int, Float> marginals;
+
+  Int i = cnf.getEmptyClauseIndex();
+  if (i != DUMMY_MIN_INT) { // empty clause found
+    showWarning("clause " + to_string(i + 1) + " of cnf is empty (1-indexing)");
+    modelCount = 0;
+    for (Int cnfVar = 1; cnfVar <= totalVarCount; cnfVar++) {
+      marginals[cnfVar] = 0;
+      marginals[-cnfVar] = 0;
+    }
+    return marginals;
   }
-  else {
-    ADD dd = mgr.addOne();
+
+  setJoinTree(cnf);
+  orderDdVars(cnf);
+  vector<JoinNode *> postorder = joinRoot->getPostorder();
+
+  /* forward pass: keeps factors of each nonterminal */
+  Map<Int, MarginalFrame> frames; // nonterminal index |-> frame
+  Map<Int, ADD> messages; // nonterminal index |-> abstracted product, until parent takes it
+  Map<Int, Set<Int>> messageDdVarSets;
+  Set<Int> projectedCnfVars;
+  for (JoinNode *joinNode : postorder) {
+    MarginalFrame &frame = frames[joinNode->getNodeIndex()];
+    vector<Int> clauseIndices;
+    Set<Int> clauseDdVars;
     for (JoinNode *child : joinNode->getChildren()) {
-      dd *= countSubtree(child, cnf, projectedCnfVars);
+      Int childIndex = child->getNodeIndex();
+      if (child->isTerminal()) {
+        clauseIndices.push_back(childIndex);
+        for (Int literal : cnf.getClauses().at(childIndex)) {
+          clauseDdVars.insert(cnfVarToDdVarMap.at(util::getCnfVar(literal)));
+        }
+      }
+      else {
+        frame.factors.push_back(messages.at(childIndex));
+        frame.factorDdVarSets.push_back(messageDdVarSets.at(childIndex));
+        frame.factorChildren.push_back(child);
+        messages.erase(childIndex);
+        messageDdVarSets.erase(childIndex);
+      }
+    }
+    if (!clauseIndices.empty()) {
+      frame.factors.push_back(getClausesDd(cnf.getClauses(), clauseIndices));
+      frame.factorDdVarSets.push_back(clauseDdVars);
+      frame.factorChildren.push_back(nullptr);
     }
+
     for (Int cnfVar : joinNode->getProjectableCnfVars()) {
+      frame.projectingDdVars.insert(cnfVarToDdVarMap.at(cnfVar));
       projectedCnfVars.insert(cnfVar);
+    }
+    Set<Int> domainDdVars;
+    for (const Set<Int> &factorDdVars : frame.factorDdVarSets) {
+      util::unionize(domainDdVars, factorDdVars);
+    }
+    util::differ(frame.boundaryDdVars, domainDdVars, frame.projectingDdVars);
+
+    ADD message = mgr.addOne();
+    for (const ADD &factor : frame.factors) message *= factor;
+    abstractCube(message, frame.projectingDdVars, cnf);
+    messages[joinNode->getNodeIndex()] = message;
+    messageDdVarSets[joinNode->getNodeIndex()] = frame.boundaryDdVars;
+  }
+  Float rootModelCount = diagram::countConstDdFloat(messages.at(joinRoot->getNodeIndex()));
+  messages.clear();
+
+  /* vars in no clause: derivative is product of sums of weights of other such vars */
+  vector<Int> freeCnfVars;
+  for (Int cnfVar = 1; cnfVar <= totalVarCount; cnfVar++) {
+    if (!util::isFound(cnfVar, projectedCnfVars)) freeCnfVars.push_back(cnfVar);
+  }
+  vector<Float> freeSuffixProducts(freeCnfVars.size() + 1, 1); // avoids dividing by zero sums
+  for (Int freeIndex = freeCnfVars.size() - 1; freeIndex >= 0; freeIndex--) {
+    Int cnfVar = freeCnfVars.at(freeIndex);
+    freeSuffixProducts.at(freeIndex) = (literalWeights.at(cnfVar) + literalWeights.at(-cnfVar)) * freeSuffixProducts.at(freeIndex + 1);
+  }
+  Float freeFactor = freeSuffixProducts.front();
+  Float freePrefixProduct = 1;
+  for (Int freeIndex = 0; freeIndex < freeCnfVars.size(); freeIndex++) {
+    Int cnfVar = freeCnfVars.at(freeIndex);
+    marginals[cnfVar] = rootModelCount * freePrefixProduct * freeSuffixProducts.at(freeIndex + 1);
+    marginals[-cnfVar] = marginals.at(cnfVar);
+    freePrefixProduct *= literalWeights.at(cnfVar) + literalWeights.at(-cnfVar);
+  }
+  modelCount = rootModelCount * freeFactor;
+
+  /* backward pass: outside ADD of nonterminal times its message sums to weighted count */
+  Map<Int, ADD> outsideDds; // nonterminal index |-> outside ADD, until nonterminal is visited
+  outsideDds[joinRoot->getNodeIndex()] = mgr.addOne();
+  for (auto it = postorder.rbegin(); it != postorder.rend(); it++) { // parents before children
+    Int nodeIndex = (*it)->getNodeIndex();
+    MarginalFrame &frame = frames.at(nodeIndex);
+    Int factorCount = frame.factors.size();
+
+    vector<ADD> suffixProducts(factorCount + 1, mgr.addOne());
+    for (Int factorIndex = factorCount - 1; factorIndex >= 0; factorIndex--) {
+      suffixProducts.at(factorIndex) = frame.factors.at(factorIndex) * suffixProducts.at(factorIndex + 1);
+    }
+    ADD prefixProduct = outsideDds.at(nodeIndex); // times factors before factorIndex
+    outsideDds.erase(nodeIndex);
+    for (Int factorIndex = 0; factorIndex < factorCount; factorIndex++) {
+      JoinNode *child = frame.factorChildren.at(factorIndex);
+      if (child != nullptr) {
+        const Set<Int> &childDdVars = frame.factorDdVarSets.at(factorIndex);
+        Set<Int> keptDdVars; // projected here but in domain of child
+        Set<Int> summedDdVars;
+        for (Int ddVar : frame.projectingDdVars) {
+          (util::isFound(ddVar, childDdVars) ? keptDdVars : summedDdVars).insert(ddVar);
+        }
+        Set<Int> summedBoundaryDdVars; // projected by ancestors, whose weights are in outside ADD
+        util::differ(summedBoundaryDdVars, frame.boundaryDdVars, childDdVars);
+
+        ADD childOutsideDd = prefixProduct * suffixProducts.at(factorIndex + 1);
+        multiplyLiteralWeights(childOutsideDd, keptDdVars, literalWeights);
+        abstractCube(childOutsideDd, summedDdVars, cnf);
+        sumDdVars(childOutsideDd, summedBoundaryDdVars);
+        outsideDds[child->getNodeIndex()] = childOutsideDd;
+      }
+      prefixProduct *= frame.factors.at(factorIndex);
+    }
 
-      Int ddVar = cnfVarToDdVarMap.at(cnfVar);
-      abstract(dd, ddVar, cnf.getLiteralWeights());
+    if (!frame.projectingDdVars.empty()) {
+      sumDdVars(prefixProduct, frame.boundaryDdVars);
+      addMarginals(marginals, prefixProduct, vector<Int>(frame.projectingDdVars.begin(), frame.projectingDdVars.end()), freeFactor, cnf);
     }
-    return dd;
+    frames.erase(nodeIndex); // releases factors
   }
+  return marginals;
 }
 
-Float Counter::countJoinTree(const Cnf &cnf) {
-  Int i = cnf.getEmptyClauseIndex();
-  if (i != DUMMY_MIN_INT) { // empty clause found
-    showWarning("clause " + to_string(i + 1) + " of cnf is empty (1-indexing)");
-    return 0;
+void Counter::outputMarginals(const Cnf &cnf) {
+  Float modelCount;
+  Map<Int, Float> marginals = computeMarginals(cnf, modelCount);
+  util::printSolutionLine(weightFormat, ExtendedFloat(modelCount), 1, 0);
+
+  const Map<Int, Float> &literalWeights = cnf.getLiteralWeights();
+  printComment("Marginals: literal, derivative of count wrt literal weight, count with literal");
+  for (Int cnfVar = 1; cnfVar <= literalWeights.size() / 2; cnfVar++) {
+    for (Int literal : {cnfVar, -cnfVar}) {
+      Float derivative = marginals.at(literal);
+      cout << "m " << literal << " " << derivative << " " << literalWeights.at(literal) * derivative << "\n";
+    }
   }
-  else {
-    orderDdVars(cnf);
+  printThinLine();
+}
 
-    Set<Int> projectedCnfVars;
-    ADD dd = countSubtree(static_cast<JoinNode *>(joinRoot), cnf, projectedCnfVars);
+ExtendedFloat Counter::countCube(const ADD &queryDd, const vector<Int> &cube, const Cnf &cnf) {
+  const Map<Int, Float> &literalWeights = cnf.getLiteralWeights();
+  ADD dd = queryDd;
+  ExtendedFloat scalar = 1; // weights of assigned query vars and of unassigned ones in no clause
+  Set<Int> assignedCnfVars;
+  for (Int literal : cube) {
+    if (util::isFound(-literal, cube)) return 0; // contradictory cube
+    Int cnfVar = util::getCnfVar(literal);
+    if (!assignedCnfVars.insert(cnfVar).second) continue; // repeated literal
+    auto it = cnfVarToDdVarMap.find(cnfVar);
+    if (it != cnfVarToDdVarMap.end()) {
+      dd = dd.Compose(literal > 0 ? mgr.addOne() : mgr.addZero(), it->second);
+    }
+    scalar *= literalWeights.at(literal);
+  }
 
-    Float modelCount = diagram::countConstDdFloat(dd);
-    modelCount = util::adjustModelCount(modelCount, projectedCnfVars, cnf.getLiteralWeights());
-    return modelCount;
+  Set<Int> summedDdVars;
+  for (Int cnfVar : queryCnfVars) {
+    if (util::isFound(cnfVar, assignedCnfVars)) continue;
+    auto it = cnfVarToDdVarMap.find(cnfVar);
+    if (it != cnfVarToDdVarMap.end()) {
+      summedDdVars.insert(it->second);
+    }
+    else {
+      scalar *= literalWeights.at(cnfVar) + literalWeights.at(-cnfVar);
+    }
   }
+
+  Int queryDdExponent = ddExponent;
+  abstractCube(dd, summedDdVars, cnf);
+  ExtendedFloat modelCount = countConstDd(dd) * scalar;
+  ddExponent = queryDdExponent; // keeps scale of queryDd for later cubes
+  return modelCount;
 }
 
-Float Counter::getModelCount(const Cnf &cnf) {
+void Counter::answerQueries(const Cnf &cnf) {
+  const Map<Int, Float> &literalWeights = cnf.getLiteralWeights();
+  for (Int cnfVar : queryCnfVars) {
+    if (cnfVar > literalWeights.size() / 2) showError("query var " + to_string(cnfVar) + " exceeds declared var count");
+  }
+
+  TimePoint compilingStartTime = util::getTimePoint();
+  ADD queryDd;
+  Set<Int> fixedCnfVars = queryCnfVars; // projected or queried
   Int i = cnf.getEmptyClauseIndex();
   if (i != DUMMY_MIN_INT) { // empty clause found
     showWarning("clause " + to_string(i + 1) + " of cnf is empty (1-indexing)");
-    return 0;
+    orderDdVars(cnf);
+    queryDd = mgr.addZero();
   }
   else {
-    return computeModelCount(cnf);
+    setJoinTree(cnf);
+    queryDd = countJoinTreeDd(cnf); // query vars are not projected
+    finishCheckpointing();
+    addSubtreeProjectableCnfVars(fixedCnfVars, joinRoot);
+  }
+  ExtendedFloat freeFactor = util::adjustModelCount(ExtendedFloat(1), fixedCnfVars, literalWeights); // vars in no clause
+  if (verbosityLevel >= 1) {
+    util::printRow("compilingSeconds", util::getSeconds(compilingStartTime));
+    util::printRow("queryAddNodeCount", queryDd.nodeCount());
+  }
+
+  std::ifstream inputFileStream;
+  std::istream *inputStream = &std::cin;
+  if (queryFilePath != STDIN_CONVENTION) {
+    inputFileStream.open(queryFilePath);
+    if (!inputFileStream.is_open()) showError("unable to open query file '" + queryFilePath + "'");
+    inputStream = &inputFileStream;
+  }
+  printComment("Answering queries (lines: q, cube, 0, count)...", 1);
+
+  TimePoint queryingStartTime = util::getTimePoint();
+  Int queryCount = 0;
+  string line;
+  while (std::getline(*inputStream, line)) {
+    std::istringstream lineStream(line);
+    vector<Int> cube;
+    string word;
+    bool valid = true;
+    while (lineStream >> word) {
+      if (word == "c") break; // comment
+      std::istringstream wordStream(word);
+      Int literal;
+      if (!(wordStream >> literal) || !wordStream.eof()) {
+        showWarning("query literal '" + word + "' is not an int; skipping line");
+        valid = false;
+        break;
+      }
+      if (literal == 0) break;
+      if (!util::isFound(util::getCnfVar(literal), queryCnfVars)) {
+        showWarning("literal " + to_string(literal) + " is not over a query var; skipping line");
+        valid = false;
+        break;
+      }
+      cube.push_back(literal);
+    }
+    if (!valid || (cube.empty() && word != "0")) continue; // blank, comment, or bad line
+
+    ExtendedFloat modelCount = countCube(queryDd, cube, cnf) * freeFactor;
+    cout << "q";
+    for (Int literal : cube) cout << " " << literal;
+    cout << " 0 " << util::getModelCountString(modelCount) << "\n";
+    queryCount++;
+  }
+
+  if (verbosityLevel >= 1) {
+    util::printRow("queryCount", queryCount);
+    util::printRow("queryingSeconds", util::getSeconds(queryingStartTime));
   }
 }
 
@@ -174,18 +1720,64 @@ void Counter::output(const string &filePath, WeightFormat weightFormat, OutputFo
   printComment("Computing output...", 1);
 
   signal(SIGINT, handleSignals); // Ctrl c
-  signal(SIGTERM, handleSignals); // timeout
+  signal(SIGTERM, checkpointDir == DUMMY_STR ? handleSignals : handleTermination); // timeout
 
   switch (outputFormat) {
     case OutputFormat::JOIN_TREE: {
       setJoinTree(cnf);
+      if (binaryJtFilePath != DUMMY_STR) {
+        JoinTreeReader::writeBinaryFile(binaryJtFilePath, joinRoot, cnf.getDeclaredVarCount(), cnf.getClauses().size(), storage::getClauseHashes(cnf));
+        printComment("Wrote binary join tree to '" + binaryJtFilePath + "'", 1);
+        break;
+      }
       printThinLine();
       printJoinTree(cnf);
       printThinLine();
       break;
     }
     case OutputFormat::MODEL_COUNT: {
-      util::printSolutionLine(weightFormat, getModelCount(cnf));
+      if (!queryCnfVars.empty()) {
+        answerQueries(cnf);
+        break;
+      }
+      if (computingMarginals) {
+        outputMarginals(cnf);
+        break;
+      }
+      if (exactCounting && weightFormat == WeightFormat::UNWEIGHTED) {
+        util::printSolutionLine(weightFormat, getExactModelCount(cnf));
+        break;
+      }
+      if (exactCounting) {
+        util::printSolutionLine(weightFormat, getExactWeightedModelCount(cnf));
+        break;
+      }
+
+      if ((epsilon > 0 || semiring != Semiring::SUM_PRODUCT) && resultCacheDir != DUMMY_STR) {
+        showWarning("result cache is unused with epsilon or semiring other than sum-product");
+      }
+      bool nonnegative = true;
+      for (const auto &literalWeight : cnf.getLiteralWeights()) {
+        if (literalWeight.second < 0) nonnegative = false;
+      }
+      if (semiring == Semiring::LOG_SUM_EXP && !nonnegative) {
+        showError("log-sum-exp semiring needs nonnegative weights");
+      }
+
+      ExtendedFloat modelCount = getCachedModelCount(cnf, filePath);
+      if (weightFormat == WeightFormat::UNWEIGHTED && modelCount.toFloat() > MAX_EXACT_FLOAT_INT) {
+        showWarning("model count exceeds 2^53 and may be rounded; --" + EXACT_COUNTING_OPTION + " 1 counts exactly");
+      }
+      if (epsilon > 0) {
+        if (verbosityLevel >= 1) util::printRow("terminalRoundingCount", totalRoundingCount);
+        if (nonnegative) {
+          util::printRow("relativeErrorBound", getRelativeErrorBound());
+        }
+        else {
+          showWarning("relative error of epsilon mode is unbounded with negative weights");
+        }
+      }
+      util::printSolutionLine(weightFormat, modelCount);
       break;
     }
     default: {
@@ -194,71 +1786,125 @@ void Counter::output(const string &filePath, WeightFormat weightFormat, OutputFo
   }
 }
 
+Counter::~Counter() {
+  delete joinTreeReader;
+  delete joinTree;
+}
+
 /* class JoinTreeCounter ******************************************************/
 
-void JoinTreeCounter::constructJoinTree(const Cnf &cnf) {}
+void JoinTreeCounter::readJoinTree(const Cnf &cnf, bool speculating) {
+  CountingSecondsPredictor predictor = [this, &cnf](JoinNode *joinRoot) { return predictCountingSeconds(joinRoot, cnf); }; // called by reading thread if speculating
+  delete joinTreeReader; // stops reading and frees join trees of previous read, e.g. of component or modular runs
+  joinTreeReader = nullptr;
+  if (jtPlannerCommand == DUMMY_STR) {
+    joinTreeReader = new JoinTreeReader(jtFilePath, cnf.getClauses(), jtWaitSeconds, jtMinWaitSeconds, jtAdaptiveFactor, predictor, speculating); // outlives this call if speculating
+  }
+  else {
+    string plannerInput = jtPlannerGraph ? cnf.getPrimalGraphString() : cnf.getDimacsString();
+    joinTreeReader = new JoinTreeReader(jtPlannerCommand, plannerInput, cnf.getClauses(), jtWaitSeconds, jtMinWaitSeconds, jtAdaptiveFactor, predictor, speculating);
+  }
+  joinRoot = joinTreeReader->getJoinTreeRoot(joinTreeCount);
+
+  const HashPair &binaryCnfHashes = joinTreeReader->getBinaryCnfHashes();
+  if (binaryCnfHashes != HashPair() && binaryCnfHashes != storage::getClauseHashes(cnf)) {
+    showError("binary jt file '" + jtFilePath + "' is for another cnf or clause order");
+  }
+}
+
+void JoinTreeCounter::constructJoinTree(const Cnf &cnf) {
+  readJoinTree(cnf, false); // last legal join tree
+}
+
+ExtendedFloat JoinTreeCounter::computeModelCount(const Cnf &cnf) {
+  readJoinTree(cnf, jtRestartRatio > 0);
+  TimePoint countingStartTime = util::getTimePoint();
 
-Float JoinTreeCounter::computeModelCount(const Cnf &cnf) {
   bool testing = false;
   // testing = true;
   if (testing) {
     printJoinTree(cnf);
   }
 
-  return countJoinTree(cnf);
+  ExtendedFloat modelCount = countJoinTree(cnf);
+  joinTreeReader->stopReading();
+
+  if (verbosityLevel >= 1) {
+    util::printRow("planningSeconds", joinTreeReader->getPlanningSeconds());
+    util::printRow("countingSeconds", util::getSeconds(countingStartTime));
+    util::printRow("predictedCountingSeconds", predictCountingSeconds(joinRoot, cnf));
+  }
+  return modelCount;
+}
+
+void JoinTreeCounter::prepareModularRuns(const Cnf &integerWeightCnf) {
+  readJoinTree(integerWeightCnf, false); // last legal join tree; no reading thread remains to be forked
+  if (verbosityLevel >= 1) util::printRow("planningSeconds", joinTreeReader->getPlanningSeconds());
+}
+
+ExtendedFloat JoinTreeCounter::countModularly(const Cnf &integerWeightCnf) {
+  return countJoinTree(integerWeightCnf);
 }
 
-JoinTreeCounter::JoinTreeCounter(const string &jtFilePath, Float jtWaitSeconds, VarOrderingHeuristic ddVarOrderingHeuristic, bool inverseDdVarOrdering) {
+JoinTreeCounter::JoinTreeCounter(const string &jtFilePath, const string &jtPlannerCommand, bool jtPlannerGraph, Float jtWaitSeconds, Float jtMinWaitSeconds, Float jtAdaptiveFactor, Float jtRestartRatio, VarOrderingHeuristic ddVarOrderingHeuristic, bool inverseDdVarOrdering) {
   this->ddVarOrderingHeuristic = ddVarOrderingHeuristic;
   this->inverseDdVarOrdering = inverseDdVarOrdering;
-
-  JoinTreeReader joinTreeReader(jtFilePath, jtWaitSeconds);
-  joinRoot = joinTreeReader.getJoinTreeRoot();
+  this->jtFilePath = jtFilePath;
+  this->jtPlannerCommand = jtPlannerCommand;
+  this->jtPlannerGraph = jtPlannerGraph;
+  this->jtWaitSeconds = jtWaitSeconds;
+  this->jtMinWaitSeconds = jtMinWaitSeconds;
+  this->jtAdaptiveFactor = jtAdaptiveFactor;
+  this->jtRestartRatio = jtRestartRatio;
+  countingComponents = false;
 }
 
 /* class MonolithicCounter ****************************************************/
 
-void MonolithicCounter::setMonolithicClauseDds(vector<ADD> &clauseDds, const Cnf &cnf) {
-  clauseDds.clear();
-  for (const vector<Int> &clause : cnf.getClauses()) {
-    ADD clauseDd = getClauseDd(clause);
-    clauseDds.push_back(clauseDd);
-  }
-}
-
 void MonolithicCounter::setCnfDd(ADD &cnfDd, const Cnf &cnf) {
-  vector<ADD> clauseDds;
-  setMonolithicClauseDds(clauseDds, cnf);
-  cnfDd = mgr.addOne();
-  for (const ADD &clauseDd : clauseDds) {
-    cnfDd &= clauseDd; // operator& is operator* in class ADD
+  vector<Int> clauseIndices;
+  for (Int clauseIndex = 0; clauseIndex < cnf.getClauses().size(); clauseIndex++) {
+    clauseIndices.push_back(clauseIndex);
   }
+  cnfDd = getClausesDd(cnf.getClauses(), clauseIndices);
 }
 
 void MonolithicCounter::constructJoinTree(const Cnf &cnf) {
-  vector<JoinNode *> terminals;
-  for (Int clauseIndex = 0; clauseIndex < cnf.getClauses().size(); clauseIndex++) {
-    terminals.push_back(new JoinTerminal());
+  Int clauseCount = cnf.getClauses().size();
+  startJoinTree(cnf, clauseCount);
+
+  vector<Int> terminals;
+  for (Int clauseIndex = 0; clauseIndex < clauseCount; clauseIndex++) {
+    terminals.push_back(clauseIndex);
   }
 
   vector<Int> projectableCnfVars = cnf.getApparentVars();
 
-  joinRoot = new JoinNonterminal(terminals, Set<Int>(projectableCnfVars.begin(), projectableCnfVars.end()));
+  joinRoot = joinTree->getJoinNode(joinTree->addNonterminal(terminals, Set<Int>(projectableCnfVars.begin(), projectableCnfVars.end())));
 }
 
-Float MonolithicCounter::computeModelCount(const Cnf &cnf) {
+ExtendedFloat MonolithicCounter::computeModelCount(const Cnf &cnf) {
+  if (checkpointDir != DUMMY_STR) {
+    showWarning("monolithic counting has no checkpoints");
+  }
+
   orderDdVars(cnf);
 
   ADD cnfDd;
-  setCnfDd(cnfDd, cnf);
-
-  Set<Int> support = util::getSupport(cnfDd);
-  for (Int ddVar : support) {
-    abstract(cnfDd, ddVar, cnf.getLiteralWeights());
+  Set<Int> support;
+  if (multiplicationSchedule == MultiplicationSchedule::LEFT_TO_RIGHT) {
+    setCnfDd(cnfDd, cnf);
+    support = util::getSupport(cnfDd);
+    abstractCube(cnfDd, support, cnf);
+  }
+  else { // clause ADDs as operands let vars be abstracted before whole cnf is conjoined
+    vector<ADD> clauseDds;
+    for (const vector<Int> &clause : cnf.getClauses()) clauseDds.push_back(getClauseDd(clause));
+    for (Int cnfVar : cnf.getApparentVars()) support.insert(cnfVarToDdVarMap.at(cnfVar));
+    cnfDd = multiplyScheduled(clauseDds, support, cnf);
   }
 
-  Float modelCount = diagram::countConstDdFloat(cnfDd);
-  modelCount = util::adjustModelCount(modelCount, getCnfVars(support), cnf.getLiteralWeights());
+  ExtendedFloat modelCount = util::adjustModelCount(countConstDd(cnfDd), getCnfVars(support), cnf.getLiteralWeights());
   return modelCount;
 }
 
@@ -287,7 +1933,7 @@ void LinearCounter::fillProjectableCnfVarSets(const vector<vector<Int>> &clauses
 
 void LinearCounter::setLinearClauseDds(vector<ADD> &clauseDds, const Cnf &cnf) {
   clauseDds.clear();
-  clauseDds.push_back(mgr.addOne());
+  clauseDds.push_back(getOneDd());
   for (const vector<Int> &clause : cnf.getClauses()) {
     ADD clauseDd = getClauseDd(clause);
     clauseDds.push_back(clauseDd);
@@ -298,44 +1944,65 @@ void LinearCounter::constructJoinTree(const Cnf &cnf) {
   const vector<vector<Int>> &clauses = cnf.getClauses();
   fillProjectableCnfVarSets(clauses);
 
-  vector<JoinNode *> clauseNodes;
-  for (Int clauseIndex = 0; clauseIndex < clauses.size(); clauseIndex++) {
-    clauseNodes.push_back(new JoinTerminal());
-  }
+  startJoinTree(cnf, clauses.size()); // terminal index is clause index
 
-  joinRoot = new JoinNonterminal({clauseNodes.at(0)}, projectableCnfVarSets.at(0));
+  Int rootIndex = joinTree->addNonterminal({0}, projectableCnfVarSets.at(0));
 
   for (Int clauseIndex = 1; clauseIndex < clauses.size(); clauseIndex++) {
-    joinRoot = new JoinNonterminal({joinRoot, clauseNodes.at(clauseIndex)}, projectableCnfVarSets.at(clauseIndex));
+    rootIndex = joinTree->addNonterminal({rootIndex, clauseIndex}, projectableCnfVarSets.at(clauseIndex));
   }
+  joinRoot = joinTree->getJoinNode(rootIndex);
 }
 
-Float LinearCounter::computeModelCount(const Cnf &cnf) {
+ExtendedFloat LinearCounter::computeModelCount(const Cnf &cnf) {
+  startCheckpointing(cnf, "linear");
   orderDdVars(cnf);
 
   vector<ADD> factorDds;
   setLinearClauseDds(factorDds, cnf);
   Set<Int> projectedCnfVars;
+  if (resuming) { // unmultiplied factors are clause ADDs
+    factorDds.resize(restoredCheckpoint.position - 1);
+    factorDds.push_back(util::getSoleMember(restoredCheckpoint.dds));
+    projectedCnfVars.insert(restoredCheckpoint.projectedCnfVars.begin(), restoredCheckpoint.projectedCnfVars.end());
+  }
+  Float constantFactor = 1; // of constant products, kept out of factorDds
   while (factorDds.size() > 1) {
+    if (isCheckpointDue()) {
+      foldConstant(factorDds.back(), constantFactor);
+      Checkpoint checkpoint;
+      checkpoint.dds = {factorDds.back()};
+      checkpoint.ddTags = {0};
+      checkpoint.ddPositions = {0};
+      saveCheckpoint(checkpoint, factorDds.size(), projectedCnfVars);
+    }
+
     ADD factor1, factor2;
     util::popBack(factor1, factorDds);
     util::popBack(factor2, factorDds);
 
-    ADD product = factor1 * factor2;
+    ADD product = factor1;
+    multiplyDds(product, factor2);
+    if (isZeroDd(product)) { // count is 0 whatever remains
+      factorDds = {product};
+      break;
+    }
     Set<Int> productDdVars = util::getSupport(product);
 
     Set<Int> otherDdVars = util::getSupportSuperset(factorDds);
 
     Set<Int> projectingDdVars;
     util::differ(projectingDdVars, productDdVars, otherDdVars);
-    abstractCube(product, projectingDdVars, cnf.getLiteralWeights());
+    abstractCube(product, projectingDdVars, cnf);
     util::unionize(projectedCnfVars, getCnfVars(projectingDdVars));
+    if (extractConstant(constantFactor, product)) product = getOneDd();
 
     factorDds.push_back(product);
   }
 
-  Float modelCount = diagram::countConstDdFloat(util::getSoleMember(factorDds));
-  modelCount = util::adjustModelCount(modelCount, projectedCnfVars, cnf.getLiteralWeights());
+  ADD cnfDd = util::getSoleMember(factorDds);
+  foldConstant(cnfDd, constantFactor);
+  ExtendedFloat modelCount = util::adjustModelCount(countConstDd(cnfDd), projectedCnfVars, cnf.getLiteralWeights());
   return modelCount;
 }
 
@@ -444,12 +2111,9 @@ void NonlinearCounter::fillDdClusters(const vector<vector<Int>> &clauses, const
   fillClusters(clauses, cnfVarOrdering, usingMinVar);
   if (verbosityLevel >= 2) printClusters(clauses);
 
-  ddClusters = vector<vector<ADD>>(clusters.size(), vector<ADD>());
-  for (Int clusterIndex = 0; clusterIndex < clusters.size(); clusterIndex++) {
-    for (Int clauseIndex : clusters.at(clusterIndex)) {
-      ADD clauseDd = getClauseDd(clauses.at(clauseIndex));
-      ddClusters.at(clusterIndex).push_back(clauseDd);
-    }
+  ddClusters = vector<vector<ADD>>(clusters.size(), vector<ADD>()); // clause ADDs would dominate baseline node count of large cnfs
+  if (subformulaCaching) {
+    keyClusters = vector<vector<SubformulaKey>>(clusters.size(), vector<SubformulaKey>());
   }
 }
 
@@ -462,6 +2126,87 @@ void NonlinearCounter::fillProjectingDdVarSets(const vector<vector<Int>> &clause
   }
 }
 
+vector<Int> NonlinearCounter::getCnfVarOrdering(const Cnf &cnf) const {
+  return resuming ? restoredCheckpoint.cnfVarOrdering : cnf.getVarOrdering(cnfVarOrderingHeuristic, inverseCnfVarOrdering);
+}
+
+Int NonlinearCounter::restoreDdClusters(ADD &cnfDd, Set<Int> &projectedCnfVars) {
+  Int startClusterIndex = restoredCheckpoint.position;
+  for (Int clusterIndex = 0; clusterIndex < startClusterIndex; clusterIndex++) {
+    ddClusters.at(clusterIndex).clear();
+  }
+
+  for (Int ddIndex = 0; ddIndex < restoredCheckpoint.dds.size(); ddIndex++) {
+    Int clusterIndex = restoredCheckpoint.ddTags.at(ddIndex);
+    const ADD &dd = restoredCheckpoint.dds.at(ddIndex);
+    if (clusterIndex == DUMMY_MAX_INT) {
+      cnfDd = dd;
+    }
+    else {
+      ddClusters.at(clusterIndex).push_back(dd);
+    }
+  }
+  restoredCheckpoint.dds.clear();
+
+  projectedCnfVars.insert(restoredCheckpoint.projectedCnfVars.begin(), restoredCheckpoint.projectedCnfVars.end());
+  return startClusterIndex;
+}
+
+void NonlinearCounter::saveTreeClusteringCheckpoint(Int clusterIndex, const vector<Int> &cnfVarOrdering, const ADD &cnfDd, const Set<Int> &projectedCnfVars) {
+  Checkpoint checkpoint;
+  checkpoint.cnfVarOrdering = cnfVarOrdering;
+  for (Int i = clusterIndex; i < ddClusters.size(); i++) {
+    const vector<ADD> &ddCluster = ddClusters.at(i);
+    for (const ADD &dd : ddCluster) { // clause ADDs are rebuilt on resumption
+      checkpoint.dds.push_back(dd);
+      checkpoint.ddTags.push_back(i);
+      checkpoint.ddPositions.push_back(0);
+    }
+    for (Int spillId : spilledDdIdClusters.at(i)) {
+      checkpoint.dds.push_back(spillManager.peek(spillId, mgr));
+      checkpoint.ddTags.push_back(i);
+      checkpoint.ddPositions.push_back(0);
+    }
+  }
+  checkpoint.dds.push_back(cnfDd);
+  checkpoint.ddTags.push_back(DUMMY_MAX_INT);
+  checkpoint.ddPositions.push_back(0);
+  saveCheckpoint(checkpoint, clusterIndex, projectedCnfVars);
+}
+
+void NonlinearCounter::spillDdClusters(Int clusterIndex, bool cachingSubformulas) {
+  for (Int i = ddClusters.size() - 1; i > clusterIndex; i--) { // latest clusters are processed last
+    vector<ADD> &ddCluster = ddClusters.at(i);
+    for (Int j = ddCluster.size() - 1; j >= 0; j--) {
+      if (!spillManager.isUnderPressure(mgr)) return;
+      if (!spillManager.isWorthSpilling(ddCluster.at(j))) continue;
+
+      Int spillId = spillManager.spill(ddCluster.at(j));
+      if (spillId == DUMMY_MIN_INT) return;
+
+      spilledDdIdClusters.at(i).push_back(spillId);
+      ddCluster.erase(ddCluster.begin() + j);
+      if (cachingSubformulas) {
+        spilledKeyClusters.at(i).push_back(keyClusters.at(i).at(j));
+        keyClusters.at(i).erase(keyClusters.at(i).begin() + j);
+      }
+    }
+  }
+}
+
+void NonlinearCounter::reloadDdCluster(Int clusterIndex, bool cachingSubformulas) {
+  for (Int spillId : spilledDdIdClusters.at(clusterIndex)) {
+    ddClusters.at(clusterIndex).push_back(spillManager.reload(spillId, mgr));
+  }
+  spilledDdIdClusters.at(clusterIndex).clear();
+
+  if (cachingSubformulas) {
+    vector<SubformulaKey> &spilledKeys = spilledKeyClusters.at(clusterIndex);
+    keyClusters.at(clusterIndex).insert(keyClusters.at(clusterIndex).end(), spilledKeys.begin(), spilledKeys.end());
+    spilledKeys.clear();
+  }
+}
+
 Int NonlinearCounter::getTargetClusterIndex(Int clusterIndex) const {
   const Set<Int> &remainingCnfVars = occurrentCnfVarSets.at(clusterIndex);
   for (Int i = clusterIndex + 1; i < clusters.size(); i++) {
@@ -508,38 +2253,31 @@ void NonlinearCounter::constructJoinTreeUsingListClustering(const Cnf &cnf, bool
     printProjectableCnfVarSets();
   }
 
-  vector<JoinNode *> terminals;
-  for (Int clauseIndex = 0; clauseIndex < clauses.size(); clauseIndex++) {
-    terminals.push_back(new JoinTerminal());
+  startJoinTree(cnf, clauses.size()); // terminal index is clause index
+
+  Int nonNullClusterNodeIndex = 0;
+  while (clusters.at(nonNullClusterNodeIndex).empty()) {
+    nonNullClusterNodeIndex++;
   }
 
   /* creates cluster nodes: */
-  vector<JoinNonterminal *> clusterNodes(clusters.size(), nullptr); // null node for empty cluster
+  vector<Int> clusterNodes(clusters.size(), DUMMY_MIN_INT); // DUMMY_MIN_INT for empty cluster
   for (Int clusterIndex = 0; clusterIndex < clusters.size(); clusterIndex++) {
     const vector<Int> &clauseIndices = clusters.at(clusterIndex);
     if (!clauseIndices.empty()) {
-      vector<JoinNode *> children;
-      for (Int clauseIndex : clauseIndices) {
-        children.push_back(terminals.at(clauseIndex));
-      }
-      clusterNodes.at(clusterIndex) = new JoinNonterminal(children);
+      Set<Int> projectableCnfVars = clusterIndex == nonNullClusterNodeIndex ? projectableCnfVarSets.at(clusterIndex) : Set<Int>();
+      clusterNodes.at(clusterIndex) = joinTree->addNonterminal(clauseIndices, projectableCnfVars);
     }
   }
 
-  Int nonNullClusterNodeIndex = 0;
-  while (clusterNodes.at(nonNullClusterNodeIndex) == nullptr) {
-    nonNullClusterNodeIndex++;
-  }
-  JoinNonterminal *nonterminal = clusterNodes.at(nonNullClusterNodeIndex);
-  nonterminal->addProjectableCnfVars(projectableCnfVarSets.at(nonNullClusterNodeIndex));
-  joinRoot = nonterminal;
-
+  Int rootIndex = clusterNodes.at(nonNullClusterNodeIndex);
   for (Int clusterIndex = nonNullClusterNodeIndex + 1; clusterIndex < clusters.size(); clusterIndex++) {
-    JoinNonterminal *clusterNode = clusterNodes.at(clusterIndex);
-    if (clusterNode != nullptr) {
-      joinRoot = new JoinNonterminal({joinRoot, clusterNode}, projectableCnfVarSets.at(clusterIndex));
+    Int clusterNode = clusterNodes.at(clusterIndex);
+    if (clusterNode != DUMMY_MIN_INT) {
+      rootIndex = joinTree->addNonterminal({rootIndex, clusterNode}, projectableCnfVarSets.at(clusterIndex));
     }
   }
+  joinRoot = joinTree->getJoinNode(rootIndex);
 }
 
 void NonlinearCounter::constructJoinTreeUsingTreeClustering(const Cnf &cnf, bool usingMinVar) {
@@ -555,27 +2293,20 @@ void NonlinearCounter::constructJoinTreeUsingTreeClustering(const Cnf &cnf, bool
     printProjectableCnfVarSets();
   }
 
-  vector<JoinNode *> terminals;
-  for (Int clauseIndex = 0; clauseIndex < clauses.size(); clauseIndex++) {
-    terminals.push_back(new JoinTerminal());
-  }
+  startJoinTree(cnf, clauses.size()); // terminal index is clause index
 
   Int clusterCount = clusters.size();
-  joinNodeSets = vector<vector<JoinNode *>>(clusterCount, vector<JoinNode *>()); // clusterIndex -> non-null nodes
+  joinNodeSets = vector<vector<Int>>(clusterCount, vector<Int>()); // clusterIndex -> node indexes
 
   /* creates cluster nodes: */
   for (Int clusterIndex = 0; clusterIndex < clusterCount; clusterIndex++) {
     const vector<Int> &clauseIndices = clusters.at(clusterIndex);
     if (!clauseIndices.empty()) {
-      vector<JoinNode *> children;
-      for (Int clauseIndex : clauseIndices) {
-        children.push_back(terminals.at(clauseIndex));
-      }
-      joinNodeSets.at(clusterIndex).push_back(new JoinNonterminal(children));
+      joinNodeSets.at(clusterIndex).push_back(joinTree->addNonterminal(clauseIndices));
     }
   }
 
-  vector<JoinNode *> rootChildren;
+  vector<Int> rootChildren;
   for (Int clusterIndex = 0; clusterIndex < clusterCount; clusterIndex++) {
     if (joinNodeSets.at(clusterIndex).empty()) continue;
 
@@ -592,77 +2323,149 @@ void NonlinearCounter::constructJoinTreeUsingTreeClustering(const Cnf &cnf, bool
     else if (targetClusterIndex < clusterCount) { // some var remains
       util::unionize(occurrentCnfVarSets.at(targetClusterIndex), remainingCnfVars);
 
-      JoinNonterminal *nonterminal = new JoinNonterminal(joinNodeSets.at(clusterIndex), projectableCnfVars);
-      joinNodeSets.at(targetClusterIndex).push_back(nonterminal);
+      joinNodeSets.at(targetClusterIndex).push_back(joinTree->addNonterminal(joinNodeSets.at(clusterIndex), projectableCnfVars));
     }
     else if (targetClusterIndex < DUMMY_MAX_INT) {
       showError("clusterCount <= targetClusterIndex < DUMMY_MAX_INT");
     }
     else { // no var remains
-      JoinNonterminal *nonterminal = new JoinNonterminal(joinNodeSets.at(clusterIndex), projectableCnfVars);
-      rootChildren.push_back(nonterminal);
+      rootChildren.push_back(joinTree->addNonterminal(joinNodeSets.at(clusterIndex), projectableCnfVars));
     }
   }
-  joinRoot = new JoinNonterminal(rootChildren);
+  joinRoot = joinTree->getJoinNode(joinTree->addNonterminal(rootChildren));
 }
 
-Float NonlinearCounter::countUsingListClustering(const Cnf &cnf, bool usingMinVar) {
+ExtendedFloat NonlinearCounter::countUsingListClustering(const Cnf &cnf, bool usingMinVar) {
+  startCheckpointing(cnf, "list clustering " + to_string(usingMinVar));
   orderDdVars(cnf);
 
-  vector<Int> cnfVarOrdering = cnf.getVarOrdering(cnfVarOrderingHeuristic, inverseCnfVarOrdering);
+  vector<Int> cnfVarOrdering = getCnfVarOrdering(cnf);
   const vector<vector<Int>> &clauses = cnf.getClauses();
 
   fillClusters(clauses, cnfVarOrdering, usingMinVar);
   if (verbosityLevel >= 2) printClusters(clauses);
 
   /* builds ADD for CNF: */
-  ADD cnfDd = mgr.addOne();
+  ADD cnfDd = getOneDd();
   Set<Int> projectedCnfVars;
-  for (Int clusterIndex = 0; clusterIndex < clusters.size(); clusterIndex++) {
-    /* builds ADD for cluster: */
-    ADD clusterDd = mgr.addOne();
-    const vector<Int> &clauseIndices = clusters.at(clusterIndex);
-    for (Int clauseIndex : clauseIndices) {
-      ADD clauseDd = getClauseDd(clauses.at(clauseIndex));
-      clusterDd *= clauseDd;
+  Int startClusterIndex = 0;
+  if (resuming) {
+    cnfDd = util::getSoleMember(restoredCheckpoint.dds);
+    projectedCnfVars.insert(restoredCheckpoint.projectedCnfVars.begin(), restoredCheckpoint.projectedCnfVars.end());
+    startClusterIndex = restoredCheckpoint.position;
+  }
+  Float constantFactor = 1; // of constant cnfDd, kept out of it
+  for (Int clusterIndex = startClusterIndex; clusterIndex < clusters.size(); clusterIndex++) {
+    if (isCheckpointDue()) {
+      foldConstant(cnfDd, constantFactor);
+      Checkpoint checkpoint;
+      checkpoint.cnfVarOrdering = cnfVarOrdering;
+      checkpoint.dds = {cnfDd};
+      checkpoint.ddTags = {DUMMY_MAX_INT};
+      checkpoint.ddPositions = {0};
+      saveCheckpoint(checkpoint, clusterIndex, projectedCnfVars);
     }
 
-    cnfDd *= clusterDd;
+    multiplyDds(cnfDd, getClausesDd(clauses, clusters.at(clusterIndex)));
+    if (isZeroDd(cnfDd)) break; // count is 0 whatever remains
 
     Set<Int> projectingDdVars = getProjectingDdVars(clusterIndex, usingMinVar, cnfVarOrdering, clauses);
-    abstractCube(cnfDd, projectingDdVars, cnf.getLiteralWeights());
+    abstractCube(cnfDd, projectingDdVars, cnf);
     util::unionize(projectedCnfVars, getCnfVars(projectingDdVars));
+    if (extractConstant(constantFactor, cnfDd)) cnfDd = getOneDd();
   }
+  foldConstant(cnfDd, constantFactor);
 
-  Float modelCount = diagram::countConstDdFloat(cnfDd);
-  modelCount = util::adjustModelCount(modelCount, cnfVarOrdering, cnf.getLiteralWeights());
+  ExtendedFloat modelCount = util::adjustModelCount(countConstDd(cnfDd), cnfVarOrdering, cnf.getLiteralWeights());
   return modelCount;
 }
 
-Float NonlinearCounter::countUsingTreeClustering(const Cnf &cnf, bool usingMinVar) {
+ExtendedFloat NonlinearCounter::countUsingTreeClustering(const Cnf &cnf, bool usingMinVar) {
+  startCheckpointing(cnf, "tree clustering " + to_string(usingMinVar));
   orderDdVars(cnf);
 
-  vector<Int> cnfVarOrdering = cnf.getVarOrdering(cnfVarOrderingHeuristic, inverseCnfVarOrdering);
+  vector<Int> cnfVarOrdering = getCnfVarOrdering(cnf);
   const vector<vector<Int>> &clauses = cnf.getClauses();
 
   fillProjectingDdVarSets(clauses, cnfVarOrdering, usingMinVar);
+  subformulaCache = SubformulaCache(); // entries depend on ddVar ordering
 
   /* builds ADD for CNF: */
-  ADD cnfDd = mgr.addOne();
+  ADD cnfDd = getOneDd();
   Set<Int> projectedCnfVars;
+  Int startClusterIndex = resuming ? restoreDdClusters(cnfDd, projectedCnfVars) : 0;
+  bool cachingSubformulas = subformulaCaching && !resuming && !extendedRange && epsilon <= 0; // keys of restored ADDs are unknown; scales and errors of cluster ADDs are mixed into ddExponent and roundingCount
+  if (subformulaCaching && (extendedRange || epsilon > 0)) {
+    showWarning("tree clustering caches no subformulas with extended range or epsilon");
+  }
   Int clusterCount = clusters.size();
-  for (Int clusterIndex = 0; clusterIndex < clusterCount; clusterIndex++) {
-    const vector<ADD> &ddCluster = ddClusters.at(clusterIndex);
-    if (!ddCluster.empty()) {
-      /* builds ADD for cluster: */
-      ADD clusterDd = mgr.addOne();
-      for (const ADD &dd : ddCluster) clusterDd *= dd;
+  startSpilling();
+  spilledDdIdClusters = vector<vector<Int>>(clusterCount, vector<Int>());
+  spilledKeyClusters = vector<vector<SubformulaKey>>(clusterCount, vector<SubformulaKey>());
+  Float constantFactor = 1; // of cluster ADDs without vars, kept out of cnfDd
+  for (Int clusterIndex = startClusterIndex; clusterIndex < clusterCount; clusterIndex++) {
+    reloadDdCluster(clusterIndex, cachingSubformulas);
+    vector<ADD> &ddCluster = ddClusters.at(clusterIndex);
+    const vector<Int> &clauseIndices = clusters.at(clusterIndex);
+    if (!clauseIndices.empty() || !ddCluster.empty()) {
+      if (isCheckpointDue()) {
+        foldConstant(cnfDd, constantFactor);
+        saveTreeClusteringCheckpoint(clusterIndex, cnfVarOrdering, cnfDd, projectedCnfVars);
+      }
 
       Set<Int> projectingDdVars = projectingDdVarSets.at(clusterIndex);
       if (usingMinVar && projectingDdVars.size() != 1) showError("wrong number of projecting vars (bucket elimination)");
 
-      abstractCube(clusterDd, projectingDdVars, cnf.getLiteralWeights());
+      SubformulaKey key;
+      ADD clusterDd;
+      vector<Int> cachedBoundaryCnfVars;
+      bool cacheHit = false;
+      if (cachingSubformulas) {
+        SubformulaHasher hasher;
+        for (Int clauseIndex : clauseIndices) {
+          hasher.addSubformula(getClauseKey(clauses.at(clauseIndex)));
+        }
+        for (const SubformulaKey &inputKey : keyClusters.at(clusterIndex)) {
+          hasher.addSubformula(inputKey);
+        }
+        hasher.addProjectedCnfVars(getCnfVars(projectingDdVars), cnf.getLiteralWeights());
+        key = hasher.getKey();
+
+        Int cachedDdExponent; // 0 unless extendedRange
+        Int cachedRoundingCount; // 0 unless epsilon > 0
+        cacheHit = subformulaCache.lookUp(clusterDd, cachedDdExponent, cachedRoundingCount, cachedBoundaryCnfVars, key);
+      }
+
+      if (cacheHit) {
+        clusterDd = renameCnfVars(clusterDd, cachedBoundaryCnfVars, key.boundaryCnfVars);
+      }
+      else {
+        /* builds ADD for cluster: */
+        clusterDd = getClausesDd(clauses, clauseIndices); // just in time
+        if (multiplicationSchedule == MultiplicationSchedule::LEFT_TO_RIGHT) {
+          for (const ADD &dd : ddCluster) multiplyDds(clusterDd, dd);
+          normalize(clusterDd);
+
+          abstractCube(clusterDd, projectingDdVars, cnf);
+        }
+        else {
+          vector<ADD> factorDds = ddCluster;
+          factorDds.push_back(clusterDd);
+          clusterDd = multiplyScheduled(factorDds, projectingDdVars, cnf);
+        }
+
+        if (cachingSubformulas) {
+          subformulaCache.insertOnline(clusterDd, key);
+        }
+      }
+      if (isZeroDd(clusterDd)) { // count is 0 whatever remains
+        cnfDd = clusterDd;
+        constantFactor = 1;
+        break;
+      }
       util::unionize(projectedCnfVars, getCnfVars(projectingDdVars));
+      ddCluster.clear(); // releases intermediate ADDs
+      if (cachingSubformulas) keyClusters.at(clusterIndex).clear();
 
       Int newClusterIndex = getNewClusterIndex(clusterDd, cnfVarOrdering, usingMinVar);
 
@@ -671,21 +2474,34 @@ Float NonlinearCounter::countUsingTreeClustering(const Cnf &cnf, bool usingMinVa
       }
       else if (newClusterIndex < clusterCount) { // some var remains
         ddClusters.at(newClusterIndex).push_back(clusterDd);
+        if (cachingSubformulas) {
+          keyClusters.at(newClusterIndex).push_back(key);
+        }
       }
       else if (newClusterIndex < DUMMY_MAX_INT) {
         showError("clusterCount <= newClusterIndex < DUMMY_MAX_INT");
       }
-      else { // no var remains
-        cnfDd *= clusterDd;
+      else if (!extractConstant(constantFactor, clusterDd)) { // no var remains
+        multiplyDds(cnfDd, clusterDd);
+        normalize(cnfDd);
+      }
+
+      if (spillManager.isUnderPressure(mgr)) {
+        spillDdClusters(clusterIndex, cachingSubformulas);
       }
     }
   }
+  finishSpilling();
+  foldConstant(cnfDd, constantFactor);
+
+  if (cachingSubformulas && verbosityLevel >= 1) {
+    subformulaCache.printStats();
+  }
 
-  Float modelCount = diagram::countConstDdFloat(cnfDd);
-  modelCount = util::adjustModelCount(modelCount, projectedCnfVars, cnf.getLiteralWeights());
+  ExtendedFloat modelCount = util::adjustModelCount(countConstDd(cnfDd), projectedCnfVars, cnf.getLiteralWeights());
   return modelCount;
 }
-Float NonlinearCounter::countUsingTreeClustering(const Cnf &cnf) { // #MAVC
+ExtendedFloat NonlinearCounter::countUsingTreeClustering(const Cnf &cnf) { // #MAVC
   orderDdVars(cnf);
 
   vector<Int> cnfVarOrdering = cnf.getVarOrdering(cnfVarOrderingHeuristic, inverseCnfVarOrdering);
@@ -696,16 +2512,20 @@ Float NonlinearCounter::countUsingTreeClustering(const Cnf &cnf) { // #MAVC
   fillProjectingDdVarSets(clauses, cnfVarOrdering, usingMinVar);
 
   vector<Set<Int>> clustersDdVars; // clusterIndex |-> ddVars
-  for (const auto &ddCluster : ddClusters) {
-    clustersDdVars.push_back(util::getSupportSuperset(ddCluster));
+  for (const vector<Int> &clauseIndices : clusters) {
+    clustersDdVars.push_back(Set<Int>());
+    for (Int clauseIndex : clauseIndices) {
+      for (Int cnfVar : util::getClauseCnfVars(clauses.at(clauseIndex))) {
+        clustersDdVars.back().insert(cnfVarToDdVarMap.at(cnfVar));
+      }
+    }
   }
 
   Set<Int> cnfDdVars;
   size_t maxDdVarCount = 0;
   Int clusterCount = clusters.size();
   for (Int clusterIndex = 0; clusterIndex < clusterCount; clusterIndex++) {
-    const vector<ADD> &ddCluster = ddClusters.at(clusterIndex);
-    if (!ddCluster.empty()) {
+    if (!clustersDdVars.at(clusterIndex).empty()) {
       Set<Int> clusterDdVars = clustersDdVars.at(clusterIndex);
 
       maxDdVarCount = std::max(maxDdVarCount, clusterDdVars.size());
@@ -745,7 +2565,7 @@ void BucketCounter::constructJoinTree(const Cnf &cnf) {
   return usingTreeClustering ? NonlinearCounter::constructJoinTreeUsingTreeClustering(cnf, usingMinVar) : NonlinearCounter::constructJoinTreeUsingListClustering(cnf, usingMinVar);
 }
 
-Float BucketCounter::computeModelCount(const Cnf &cnf) {
+ExtendedFloat BucketCounter::computeModelCount(const Cnf &cnf) {
   bool usingMinVar = true;
   return usingTreeClustering ? NonlinearCounter::countUsingTreeClustering(cnf, usingMinVar) : NonlinearCounter::countUsingListClustering(cnf, usingMinVar);
 }
@@ -765,7 +2585,7 @@ void BouquetCounter::constructJoinTree(const Cnf &cnf) {
   return usingTreeClustering ? NonlinearCounter::constructJoinTreeUsingTreeClustering(cnf, usingMinVar) : NonlinearCounter::constructJoinTreeUsingListClustering(cnf, usingMinVar);
 }
 
-Float BouquetCounter::computeModelCount(const Cnf &cnf) {
+ExtendedFloat BouquetCounter::computeModelCount(const Cnf &cnf) {
   bool usingMinVar = false;
   // return NonlinearCounter::countUsingTreeClustering(cnf); // #MAVC
   return usingTreeClustering ? NonlinearCounter::countUsingTreeClustering(cnf, usingMinVar) : NonlinearCounter::countUsingListClustering(cnf, usingMinVar);
@@ -12,6 +12,8 @@ const string &WEIGHT_WORD = "w";
 const Float CACHET_DEFAULT_VAR_WEIGHT = 0.5;
 const Float MCC_DEFAULT_LITERAL_WEIGHT = 1.0;
 
+const Int MAX_INTEGER_WEIGHT = Int(1) << 52;
+
 /* classes ********************************************************************/
 
 /* class Label ****************************************************************/
@@ -33,6 +35,36 @@ void Cnf::addClause(const vector<Int> &clause) {
   for (Int literal : clause) updateApparentVars(literal);
 }
 
+void Cnf::setDecimalWeight(Int literal, const string &weightWord) {
+  Decimal decimal;
+  if (util::parseDecimal(decimal, weightWord)) {
+    decimalLiteralWeights[literal] = decimal;
+  }
+  else {
+    decimalLiteralWeights.erase(literal);
+  }
+}
+
+void Cnf::classifyVarWeights() {
+  varWeightClasses.clear();
+  for (const std::pair<const Int, Float> &kv : literalWeights) {
+    Int var = kv.first;
+    if (var < 0) continue;
+
+    Float positiveWeight = kv.second;
+    Float negativeWeight = literalWeights.at(-var);
+    if (positiveWeight == negativeWeight) {
+      varWeightClasses[var] = positiveWeight == 1 ? WeightClass::UNIT : WeightClass::EQUAL;
+    }
+    else if (positiveWeight == 0 || negativeWeight == 0) {
+      varWeightClasses[var] = WeightClass::RESTRICTING;
+    }
+    else {
+      varWeightClasses[var] = WeightClass::GENERAL;
+    }
+  }
+}
+
 Graph Cnf::getGaifmanGraph() const {
   Set<Int> vars;
   for (Int var : apparentVars) vars.insert(var);
@@ -199,9 +231,13 @@ vector<Int> Cnf::getVarOrdering(VarOrderingHeuristic varOrderingHeuristic, bool
   return varOrdering;
 }
 
+WeightFormat Cnf::getWeightFormat() const { return weightFormat; }
+
 Int Cnf::getDeclaredVarCount() const { return declaredVarCount; }
 
-Map<Int, Float> Cnf::getLiteralWeights() const { return literalWeights; }
+const Map<Int, Float> &Cnf::getLiteralWeights() const { return literalWeights; }
+
+WeightClass Cnf::getVarWeightClass(Int cnfVar) const { return varWeightClasses.at(cnfVar); }
 
 Int Cnf::getEmptyClauseIndex() const {
   for (Int clauseIndex = 0; clauseIndex < clauses.size(); clauseIndex++) {
@@ -216,6 +252,99 @@ const vector<vector<Int>> &Cnf::getClauses() const { return clauses; }
 
 const vector<Int> &Cnf::getApparentVars() const { return apparentVars; }
 
+vector<Cnf> Cnf::getComponents() const {
+  Map<Int, Int> parentVars; // union-find forest over apparent vars
+  for (Int var : apparentVars) parentVars[var] = var;
+  auto getRootVar = [&parentVars](Int var) {
+    while (parentVars.at(var) != var) {
+      parentVars[var] = parentVars.at(parentVars.at(var)); // path halving
+      var = parentVars.at(var);
+    }
+    return var;
+  };
+
+  for (const vector<Int> &clause : clauses) {
+    if (clause.empty()) showError("empty clause in Cnf::getComponents");
+    Int rootVar = getRootVar(util::getCnfVar(clause.front()));
+    for (Int literal : clause) {
+      parentVars[getRootVar(util::getCnfVar(literal))] = rootVar;
+    }
+  }
+
+  Map<Int, Int> componentIndices; // root var |-> index in componentClauseLists
+  vector<vector<vector<Int>>> componentClauseLists;
+  for (const vector<Int> &clause : clauses) {
+    Int rootVar = getRootVar(util::getCnfVar(clause.front()));
+    if (componentIndices.find(rootVar) == componentIndices.end()) {
+      componentIndices[rootVar] = componentClauseLists.size();
+      componentClauseLists.push_back(vector<vector<Int>>());
+    }
+    componentClauseLists.at(componentIndices.at(rootVar)).push_back(clause);
+  }
+
+  vector<Cnf> components;
+  for (const vector<vector<Int>> &componentClauses : componentClauseLists) {
+    Map<Int, Int> newVars; // var |-> var in component
+    vector<vector<Int>> renamedClauses;
+    for (const vector<Int> &clause : componentClauses) {
+      vector<Int> renamedClause;
+      for (Int literal : clause) {
+        Int var = util::getCnfVar(literal);
+        if (newVars.find(var) == newVars.end()) {
+          Int newVar = newVars.size() + 1;
+          newVars[var] = newVar;
+        }
+        Int newVar = newVars.at(var);
+        renamedClause.push_back(util::isPositiveLiteral(literal) ? newVar : -newVar);
+      }
+      renamedClauses.push_back(renamedClause);
+    }
+
+    Cnf component(renamedClauses);
+    component.weightFormat = weightFormat;
+    component.declaredVarCount = newVars.size();
+    for (const std::pair<const Int, Int> &kv : newVars) {
+      component.literalWeights[kv.second] = literalWeights.at(kv.first);
+      component.literalWeights[-kv.second] = literalWeights.at(-kv.first);
+      for (Int sign : {1, -1}) {
+        auto decimal = decimalLiteralWeights.find(sign * kv.first);
+        if (decimal != decimalLiteralWeights.end()) component.decimalLiteralWeights[sign * kv.second] = decimal->second;
+      }
+    }
+    component.classifyVarWeights();
+    components.push_back(component);
+  }
+  return components;
+}
+
+Cnf Cnf::getIntegerWeightCnf(Int &decimalExponent) const {
+  Cnf integerWeightCnf(clauses);
+  integerWeightCnf.weightFormat = weightFormat;
+  integerWeightCnf.declaredVarCount = declaredVarCount;
+  decimalExponent = 0;
+  for (Int var = 1; var <= declaredVarCount; var++) {
+    if (decimalLiteralWeights.find(var) == decimalLiteralWeights.end() || decimalLiteralWeights.find(-var) == decimalLiteralWeights.end()) {
+      showError("weights of var " + to_string(var) + " are not both decimals with at most 18 significant digits");
+    }
+    const Decimal &positiveWeight = decimalLiteralWeights.at(var);
+    const Decimal &negativeWeight = decimalLiteralWeights.at(-var);
+
+    Int exponent = std::min(positiveWeight.second, negativeWeight.second); // common denominator of var
+    Int positiveSignificand;
+    Int negativeSignificand;
+    if (!util::alignDecimal(positiveSignificand, positiveWeight, exponent) || !util::alignDecimal(negativeSignificand, negativeWeight, exponent) || std::max(positiveSignificand, negativeSignificand) > MAX_INTEGER_WEIGHT) {
+      showError("weights of var " + to_string(var) + " have too many digits for a common integer scale below 2^52");
+    }
+    integerWeightCnf.literalWeights[var] = positiveSignificand;
+    integerWeightCnf.literalWeights[-var] = negativeSignificand;
+    integerWeightCnf.decimalLiteralWeights[var] = Decimal(positiveSignificand, 0);
+    integerWeightCnf.decimalLiteralWeights[-var] = Decimal(negativeSignificand, 0);
+    decimalExponent += exponent;
+  }
+  integerWeightCnf.classifyVarWeights();
+  return integerWeightCnf;
+}
+
 void Cnf::printLiteralWeights() const {
   util::printLiteralWeights(literalWeights);
 }
@@ -224,6 +353,33 @@ void Cnf::printClauses() const {
   util::printCnf(clauses);
 }
 
+string Cnf::getDimacsString() const {
+  std::ostringstream outputStringStream;
+  outputStringStream << PROBLEM_WORD << " " << CNF_WORD << " " << declaredVarCount << " " << clauses.size() << "\n";
+  for (const vector<Int> &clause : clauses) {
+    for (Int literal : clause) {
+      outputStringStream << literal << " ";
+    }
+    outputStringStream << "0\n";
+  }
+  return outputStringStream.str();
+}
+
+string Cnf::getPrimalGraphString() const {
+  Graph graph = getGaifmanGraph();
+  std::ostringstream edgeStringStream;
+  Int edgeCount = 0;
+  for (auto vertex = graph.beginVertices(); vertex != graph.endVertices(); vertex++) {
+    for (auto neighbor = graph.beginNeighbors(*vertex); neighbor != graph.endNeighbors(*vertex); neighbor++) {
+      if (*vertex < *neighbor) {
+        edgeStringStream << *vertex << " " << *neighbor << "\n";
+        edgeCount++;
+      }
+    }
+  }
+  return PROBLEM_WORD + " tw " + to_string(declaredVarCount) + " " + to_string(edgeCount) + "\n" + edgeStringStream.str();
+}
+
 Cnf::Cnf(const string &filePath, WeightFormat weightFormat) {
   printComment("Reading CNF formula...", 1);
 
@@ -302,6 +458,8 @@ Cnf::Cnf(const string &filePath, WeightFormat weightFormat) {
         for (Int var = 1; var <= declaredVarCount; var++) {
           literalWeights[var] = std::stod(words.at(var * 2));
           literalWeights[-var] = std::stod(words.at(var * 2 + 1));
+          setDecimalWeight(var, words.at(var * 2));
+          setDecimalWeight(-var, words.at(var * 2 + 1));
         }
       }
     }
@@ -317,8 +475,9 @@ Cnf::Cnf(const string &filePath, WeightFormat weightFormat) {
         }
         Float weight = std::stod(words.at(2));
         literalWeights[var] = weight;
+        setDecimalWeight(var, words.at(2));
       }
-      else if (weightFormat == WeightFormat::MCC && (wordCount == 3 || wordCount == 4 && words.at(3) == "0")) {
+      else if (weightFormat == WeightFormat::MCC && (wordCount == 3 || (wordCount == 4 && words.at(3) == "0"))) {
         Int literal = std::stoll(words.at(1));
 
         Int var = util::getCnfVar(literal);
@@ -328,6 +487,7 @@ Cnf::Cnf(const string &filePath, WeightFormat weightFormat) {
 
         Float weight = std::stod(words.at(2));
         literalWeights[literal] = weight;
+        setDecimalWeight(literal, words.at(2));
       }
       else {
         showError("weight line " + to_string(lineIndex) + " is inconsistent with weight format " + util::getWeightFormatName(weightFormat));
@@ -381,6 +541,7 @@ Cnf::Cnf(const string &filePath, WeightFormat weightFormat) {
     for (Int var = 1; var <= declaredVarCount; var++) {
       literalWeights[var] = 1;
       literalWeights[-var] = 1;
+      decimalLiteralWeights[var] = decimalLiteralWeights[-var] = Decimal(1, 0);
     }
   }
   else if (weightFormat == WeightFormat::CACHET) { // completes literalWeights
@@ -389,10 +550,23 @@ Cnf::Cnf(const string &filePath, WeightFormat weightFormat) {
       if (literalWeights.find(var) != literalWeights.end()) {
         varWeight = literalWeights.at(var);
       }
+      else {
+        setDecimalWeight(var, to_string(CACHET_DEFAULT_VAR_WEIGHT));
+      }
 
       Float negativeLiteralWeight = 1.0 - varWeight;
       if (varWeight == -1) {
         varWeight = negativeLiteralWeight = 1;
+        decimalLiteralWeights[var] = decimalLiteralWeights[-var] = Decimal(1, 0);
+      }
+      else if (decimalLiteralWeights.find(var) != decimalLiteralWeights.end()) { // 1 - varWeight, exactly
+        const Decimal &decimalVarWeight = decimalLiteralWeights.at(var);
+        Int exponent = std::min(decimalVarWeight.second, Int(0));
+        Int oneSignificand;
+        Int varSignificand;
+        if (util::alignDecimal(oneSignificand, Decimal(1, 0), exponent) && util::alignDecimal(varSignificand, decimalVarWeight, exponent)) {
+          decimalLiteralWeights[-var] = Decimal(oneSignificand - varSignificand, exponent);
+        }
       }
 
       literalWeights[var] = varWeight;
@@ -401,15 +575,17 @@ Cnf::Cnf(const string &filePath, WeightFormat weightFormat) {
   }
   else if (weightFormat == WeightFormat::MCC) { // completes literalWeights
     for (Int var = 1; var <= declaredVarCount; var++) {
-      if (literalWeights.find(var) == literalWeights.end()) {
-        literalWeights[var] = MCC_DEFAULT_LITERAL_WEIGHT;
-      }
-      if (literalWeights.find(-var) == literalWeights.end()) {
-        literalWeights[-var] = MCC_DEFAULT_LITERAL_WEIGHT;
+      for (Int literal : {var, -var}) {
+        if (literalWeights.find(literal) == literalWeights.end()) {
+          literalWeights[literal] = MCC_DEFAULT_LITERAL_WEIGHT;
+          setDecimalWeight(literal, to_string(MCC_DEFAULT_LITERAL_WEIGHT));
+        }
       }
     }
   }
 
+  classifyVarWeights();
+
   if (verbosityLevel >= 1) {
     util::printRow("declaredVarCount", declaredVarCount);
     util::printRow("apparentVarCount", apparentVars.size());
@@ -8,133 +8,189 @@ const string &JOIN_TREE_END_WORD = "="; // printed by LG after each join tree
 const string &JT_WORD = "jt";
 const string &VAR_ELIM_WORD = "e";
 
+const string &TD_SOLUTION_WORD = "s";
+const string &TD_WORD = "td";
+const string &TD_BAG_WORD = "b";
+
+const string &BINARY_JOIN_TREE_MAGIC = string("ADDMCJT\0", 8);
+const Int BINARY_JOIN_TREE_VERSION = 1;
+
+const Int PLANNER_POLL_MILLISECONDS = 100;
+const Float PLANNER_GRACE_SECONDS = 1;
+
 /* namespaces *****************************************************************/
 
 /* classes ********************************************************************/
 
-/* class JoinNode *********************************************************/
+/* class JoinNodeSpan *****************************************************/
 
-Int JoinNode::backupNodeCount;
-Int JoinNode::backupTerminalCount;
-Set<Int> JoinNode::backupNonterminalIndexes;
+JoinNode *JoinNodeSpan::Iterator::operator*() const {
+  return joinTree->getJoinNode(*nodeIndex);
+}
 
-Int JoinNode::nodeCount;
-Int JoinNode::terminalCount;
-Set<Int> JoinNode::nonterminalIndexes;
+JoinNodeSpan::Iterator &JoinNodeSpan::Iterator::operator++() {
+  nodeIndex++;
+  return *this;
+}
 
-void JoinNode::resetStaticFields() {
-  backupNodeCount = nodeCount;
-  backupTerminalCount = terminalCount;
-  backupNonterminalIndexes = nonterminalIndexes;
+bool JoinNodeSpan::Iterator::operator!=(const Iterator &other) const {
+  return nodeIndex != other.nodeIndex;
+}
 
-  nodeCount = 0;
-  terminalCount = 0;
-  nonterminalIndexes.clear();
+JoinNodeSpan::Iterator::Iterator(JoinTree *joinTree, const Int *nodeIndex) {
+  this->joinTree = joinTree;
+  this->nodeIndex = nodeIndex;
 }
 
-void JoinNode::restoreStaticFields() {
-  nodeCount = backupNodeCount;
-  terminalCount = backupTerminalCount;
-  nonterminalIndexes = backupNonterminalIndexes;
+JoinNodeSpan::Iterator JoinNodeSpan::begin() const {
+  return Iterator(joinTree, nodeIndexes.begin());
 }
 
-bool JoinNode::isTerminal() const {
-  return nodeIndex < terminalCount;
+JoinNodeSpan::Iterator JoinNodeSpan::end() const {
+  return Iterator(joinTree, nodeIndexes.end());
 }
 
-Int JoinNode::getNodeCount() const {
-  return nodeCount;
+size_t JoinNodeSpan::size() const {
+  return nodeIndexes.size();
 }
 
-Int JoinNode::getTerminalCount() const {
-  return terminalCount;
+bool JoinNodeSpan::empty() const {
+  return nodeIndexes.empty();
 }
 
-Int JoinNode::getNodeIndex() const {
-  return nodeIndex;
+JoinNode *JoinNodeSpan::at(Int i) const {
+  return joinTree->getJoinNode(nodeIndexes.at(i));
 }
 
-const vector<JoinNode *> &JoinNode::getChildren() const {
-  return children;
+JoinNodeSpan::JoinNodeSpan(JoinTree *joinTree, const Span<Int> &nodeIndexes) {
+  this->joinTree = joinTree;
+  this->nodeIndexes = nodeIndexes;
 }
 
-const Set<Int> &JoinNode::getProjectableCnfVars() const {
-  return projectableCnfVars;
+/* class JoinNode *********************************************************/
+
+JoinTree *JoinNode::getJoinTree() const {
+  return joinTree;
 }
 
-/* class JoinTerminal *****************************************************/
+bool JoinNode::isTerminal() const {
+  return nodeIndex < joinTree->terminalCount;
+}
 
-void JoinTerminal::printSubtree(const string &prefix) const {}
+Int JoinNode::getNodeIndex() const {
+  return nodeIndex;
+}
 
-JoinTerminal::JoinTerminal() {
-  nodeIndex = terminalCount;
-  terminalCount++;
-  nodeCount++;
+JoinNodeSpan JoinNode::getChildren() const {
+  return JoinNodeSpan(joinTree, Span<Int>(joinTree->childPool.data() + childOffset, childCount));
 }
 
-/* class JoinNonterminal **************************************************/
+Span<Int> JoinNode::getProjectableCnfVars() const {
+  return Span<Int>(joinTree->cnfVarPool.data() + cnfVarOffset, cnfVarCount);
+}
 
-void JoinNonterminal::printNode(const string &prefix = "") const {
+void JoinNode::printNode(const string &prefix) const {
   cout << prefix << nodeIndex + 1 << " ";
 
-  for (JoinNode *child : children) {
+  for (JoinNode *child : getChildren()) {
     cout << child->getNodeIndex() + 1 << " ";
   }
 
   cout << VAR_ELIM_WORD << " ";
-  for (Int cnfVar : projectableCnfVars) {
+  for (Int cnfVar : getProjectableCnfVars()) {
     cout << cnfVar << " ";
   }
 
   cout << "\n";
 }
 
-void JoinNonterminal::printSubtree(const string &prefix) const {
-  for (JoinNode *child : children) {
-    child->printSubtree(prefix);
+vector<JoinNode *> JoinNode::getPostorder() {
+  vector<JoinNode *> postorder;
+  if (isTerminal()) return postorder;
+
+  vector<std::pair<JoinNode *, Int>> stack = {{this, 0}}; // node, next child position
+  while (!stack.empty()) {
+    JoinNode *joinNode = stack.back().first;
+    Int childPosition = stack.back().second;
+    JoinNodeSpan children = joinNode->getChildren();
+    if (childPosition < children.size()) {
+      stack.back().second++;
+      JoinNode *child = children.at(childPosition);
+      if (!child->isTerminal()) stack.push_back({child, 0});
+    }
+    else {
+      postorder.push_back(joinNode);
+      stack.pop_back();
+    }
   }
-  printNode(prefix);
+  return postorder;
 }
 
-void JoinNonterminal::addProjectableCnfVars(const Set<Int> &cnfVars) {
-  util::unionize(projectableCnfVars, cnfVars);
+void JoinNode::printSubtree(const string &prefix) {
+  for (JoinNode *joinNode : getPostorder()) {
+    joinNode->printNode(prefix);
+  }
 }
 
-JoinNonterminal::JoinNonterminal(const vector<JoinNode *> &children, const Set<Int> &projectableCnfVars, Int requestedNodeIndex) {
-  this->children = children;
-  this->projectableCnfVars = projectableCnfVars;
+/* class JoinTree *************************************************************/
 
+Int JoinTree::getTerminalCount() const {
+  return terminalCount;
+}
+
+Int JoinTree::getNonterminalCount() const {
+  return nonterminalCount;
+}
+
+Int JoinTree::getNodeCount() const {
+  return terminalCount + nonterminalCount;
+}
+
+bool JoinTree::hasJoinNode(Int nodeIndex) const {
+  return nodeIndex >= 0 && nodeIndex < joinNodes.size() && joinNodes.at(nodeIndex).nodeIndex != DUMMY_MIN_INT;
+}
+
+JoinNode *JoinTree::getJoinNode(Int nodeIndex) {
+  return &joinNodes[nodeIndex];
+}
+
+JoinNode *JoinTree::getJoinRoot() {
+  return &joinNodes.back();
+}
+
+Int JoinTree::addNonterminal(const vector<Int> &childIndexes, const Set<Int> &projectableCnfVars, Int requestedNodeIndex) {
   if (requestedNodeIndex == DUMMY_MIN_INT) {
-    requestedNodeIndex = nodeCount;
+    requestedNodeIndex = joinNodes.size();
   }
   else if (requestedNodeIndex < terminalCount) {
     showError("requestedNodeIndex = " + to_string(requestedNodeIndex) + " < " + to_string(terminalCount) + " = terminalCount");
   }
-  else if (util::isFound(requestedNodeIndex, nonterminalIndexes)) {
+  else if (hasJoinNode(requestedNodeIndex)) {
     showError("requestedNodeIndex = " + to_string(requestedNodeIndex) + " already taken");
   }
-  nodeIndex = requestedNodeIndex;
-  nonterminalIndexes.insert(requestedNodeIndex);
-  nodeCount++;
-}
-
-/* class JoinTree *************************************************************/
-
-JoinNode *JoinTree::getJoinNode(Int nodeIndex) const {
-  auto it = joinTerminals.find(nodeIndex);
-  if (it != joinTerminals.end()) {
-    return it->second;
+  for (Int childIndex : childIndexes) {
+    if (!hasJoinNode(childIndex) || childIndex >= requestedNodeIndex) {
+      showError("child " + to_string(childIndex + 1) + " of node " + to_string(requestedNodeIndex + 1) + " is missing (1-indexing)");
+    }
   }
-  else {
-    return joinNonterminals.at(nodeIndex);
+  if (requestedNodeIndex >= joinNodes.size()) {
+    joinNodes.resize(requestedNodeIndex + 1);
   }
-}
 
-JoinNonterminal *JoinTree::getJoinRoot() const {
-  return joinNonterminals.at(declaredNodeCount - 1);
+  JoinNode &joinNode = joinNodes.at(requestedNodeIndex);
+  joinNode.joinTree = this;
+  joinNode.nodeIndex = requestedNodeIndex;
+  joinNode.childOffset = childPool.size();
+  joinNode.childCount = childIndexes.size();
+  joinNode.cnfVarOffset = cnfVarPool.size();
+  joinNode.cnfVarCount = projectableCnfVars.size();
+  childPool.insert(childPool.end(), childIndexes.begin(), childIndexes.end());
+  cnfVarPool.insert(cnfVarPool.end(), projectableCnfVars.begin(), projectableCnfVars.end());
+  nonterminalCount++;
+  return requestedNodeIndex;
 }
 
-void JoinTree::printTree() const {
+void JoinTree::printTree() {
   printComment(PROBLEM_WORD + " " + JT_WORD + " " + to_string(declaredVarCount) + " " + to_string(declaredClauseCount) + " " + to_string(declaredNodeCount));
   getJoinRoot()->printSubtree(COMMENT_WORD + "\t");
 }
@@ -143,35 +199,77 @@ JoinTree::JoinTree(Int declaredVarCount, Int declaredClauseCount, Int declaredNo
   this->declaredVarCount = declaredVarCount;
   this->declaredClauseCount = declaredClauseCount;
   this->declaredNodeCount = declaredNodeCount;
+
+  terminalCount = std::max(declaredClauseCount, (Int)0);
+  joinNodes.resize(std::max(terminalCount, declaredNodeCount));
+  for (Int terminalIndex = 0; terminalIndex < terminalCount; terminalIndex++) {
+    joinNodes.at(terminalIndex).joinTree = this;
+    joinNodes.at(terminalIndex).nodeIndex = terminalIndex;
+  }
 }
 
 /* class JoinTreeReader ***********************************************************/
 
-Int JoinTreeReader::plannerPid = DUMMY_MIN_INT;
-
-void JoinTreeReader::handleAlarm(int signal) {
-  if (signal != SIGALRM) {
-    showError("signal == " + to_string(signal) + " != " + to_string(SIGALRM) + " == SIGALRM");
+vector<string> JoinTreeReader::getCommandWords(const string &command) {
+  vector<string> words;
+  string word;
+  bool inWord = false;
+  char quote = '\0';
+  for (char c : command) {
+    if (quote != '\0') {
+      if (c == quote) quote = '\0';
+      else word += c;
+    }
+    else if (c == '\'' || c == '"') {
+      quote = c;
+      inWord = true;
+    }
+    else if (std::isspace(c)) {
+      if (inWord) words.push_back(word);
+      word.clear();
+      inWord = false;
+    }
+    else {
+      word += c;
+      inWord = true;
+    }
   }
-
-  if (plannerPid == DUMMY_MIN_INT) {
-    showError("plannerPid == DUMMY_MIN_INT");
+  if (quote != '\0') {
+    showError("unmatched quote in planner command '" + command + "'");
   }
+  if (inWord) words.push_back(word);
+  return words;
+}
 
-  if (kill(plannerPid, SIGTERM) == 0) {
-    showWarning("successfully killed planner processs with PID " + to_string(plannerPid));
-  }
-  else {
-    showError("failed to kill planner processs with PID " + to_string(plannerPid));
+void JoinTreeReader::startJoinTree(Int declaredVarCount, Int declaredClauseCount, Int declaredNodeCount) {
+  backupJoinTree = joinTree;
+
+  vector<JoinTree *> keptJoinTrees;
+  for (JoinTree *startedJoinTree : startedJoinTrees) {
+    if (startedJoinTree == backupJoinTree || util::isFound(startedJoinTree, publishedJoinTrees)) {
+      keptJoinTrees.push_back(startedJoinTree);
+    }
+    else { // superseded and never published, e.g. previous backup or incomplete join tree
+      delete startedJoinTree;
+    }
   }
+  startedJoinTrees = keptJoinTrees;
+
+  joinTree = new JoinTree(declaredVarCount, declaredClauseCount, declaredNodeCount);
+  startedJoinTrees.push_back(joinTree);
 }
 
 void JoinTreeReader::finishReadingJoinTree() {
+  if (tdSolutionLineIndex != DUMMY_MIN_INT) {
+    showWarning("discarding incomplete tree decomposition from line " + to_string(tdSolutionLineIndex));
+    tdSolutionLineIndex = DUMMY_MIN_INT;
+  }
+
   if (joinTree == nullptr) {
     showError("no join tree ending on or before line " + to_string(lineIndex));
   }
 
-  Int nonterminalCount = joinTree->joinNonterminals.size();
+  Int nonterminalCount = joinTree->nonterminalCount;
   Int expectedNonterminalCount = joinTree->declaredNodeCount - joinTree->declaredClauseCount;
   if (nonterminalCount < expectedNonterminalCount) {
     showWarning("missing branch nodes (" + to_string(nonterminalCount) + " found, " + to_string(expectedNonterminalCount) + " expected) before current join tree ends on line " + to_string(lineIndex));
@@ -189,7 +287,6 @@ void JoinTreeReader::finishReadingJoinTree() {
       }
 
       joinTree = backupJoinTree;
-      JoinNode::restoreStaticFields();
     }
   }
   else {
@@ -202,149 +299,723 @@ void JoinTreeReader::finishReadingJoinTree() {
   }
   joinTreeEndLineIndex = lineIndex;
   problemLineIndex = DUMMY_MIN_INT;
+
+  publishJoinTree();
 }
 
-void JoinTreeReader::readInputStream(std::istream *inputStream) {
-  string line;
-  while (std::getline(*inputStream, line)) {
-    lineIndex++;
-    std::istringstream inputStringStream(line);
+void JoinTreeReader::publishJoinTree() {
+  {
+    std::lock_guard<std::mutex> lock(publishingMutex);
+    if (publishedJoinTree == joinTree) return;
+  }
 
-    if (verbosityLevel >= 4) printComment("Line " + to_string(lineIndex) + "\t" + line);
+  Float countingSeconds = predictCountingSeconds(joinTree->getJoinRoot());
+  if (verbosityLevel >= 1) {
+    printComment("Join tree " + to_string(publishedJoinTreeCount + 1) + " after " + to_string(util::getSeconds(readingStartTime)) + " planning seconds predicts " + to_string(countingSeconds) + " counting seconds", 1);
+  }
 
-    vector<string> words;
-    std::copy(std::istream_iterator<string>(inputStringStream), std::istream_iterator<string>(), std::back_inserter(words));
+  {
+    std::lock_guard<std::mutex> lock(publishingMutex);
+    bestCountingSeconds = std::min(bestCountingSeconds, countingSeconds);
+    publishedJoinTree = joinTree;
+    publishedJoinTrees.insert(joinTree);
+    publishedJoinTreeCount++;
+  }
+  publishingCondition.notify_all();
+}
 
-    Int wordCount = words.size();
-    if (wordCount < 1) continue;
-    const string &startWord = words.at(0);
+void JoinTreeReader::finishReading(bool failed) {
+  {
+    std::lock_guard<std::mutex> lock(publishingMutex);
+    readingFinished = true;
+    readingFailed = failed;
+    planningSeconds = util::getSeconds(readingStartTime);
+  }
+  publishingCondition.notify_all();
+}
+
+bool JoinTreeReader::isStoppingRequested() const {
+  std::lock_guard<std::mutex> lock(publishingMutex);
+  return stoppingRequested;
+}
 
-    bool readingElimVars = false;
-    if (startWord == JOIN_TREE_END_WORD) {
-      finishReadingJoinTree();
+void JoinTreeReader::startReadingTreeDecomposition(const vector<string> &words) {
+  if (words.size() != 5) {
+    showError("solution line " + to_string(lineIndex) + " has " + to_string(words.size()) + " words (should be 5)");
+  }
+  const string &tdWord = words.at(1);
+  if (tdWord != TD_WORD) {
+    showError("expected '" + TD_WORD + "', found '" + tdWord + "' -- line " + to_string(lineIndex));
+  }
+
+  if (tdSolutionLineIndex != DUMMY_MIN_INT) {
+    showWarning("discarding incomplete tree decomposition from line " + to_string(tdSolutionLineIndex));
+  }
+  tdSolutionLineIndex = lineIndex;
+
+  Int bagCount = std::stoll(words.at(2));
+  if (bagCount < 1) {
+    showError("tree decomposition has no bags -- line " + to_string(lineIndex));
+  }
+  tdDeclaredVertexCount = std::stoll(words.at(4));
+  tdBags.assign(bagCount, vector<Int>());
+  tdReadBags.assign(bagCount, false);
+  tdReadBagCount = 0;
+  tdEdges.clear();
+}
+
+void JoinTreeReader::readTreeDecompositionLine(const vector<string> &words) {
+  Int bagCount = tdBags.size();
+  if (words.at(0) == TD_BAG_WORD) {
+    if (words.size() < 2) {
+      showError("bag line " + to_string(lineIndex) + " has no bag id");
+    }
+    Int bagIndex = std::stoll(words.at(1)) - 1; // 0-indexing
+    if (bagIndex < 0 || bagIndex >= bagCount) {
+      showError("wrong bag id '" + words.at(1) + "' -- line " + to_string(lineIndex));
     }
-    else if (startWord == PROBLEM_WORD) {
-      if (problemLineIndex != DUMMY_MIN_INT) {
-        showError("multiple problem lines: " + to_string(problemLineIndex) + " and " + to_string(lineIndex));
+    if (tdReadBags.at(bagIndex)) {
+      showError("repeated bag id '" + words.at(1) + "' -- line " + to_string(lineIndex));
+    }
+    tdReadBags.at(bagIndex) = true;
+    for (Int i = 2; i < words.size(); i++) {
+      Int cnfVar = std::stoll(words.at(i));
+      if (cnfVar <= 0 || cnfVar > tdDeclaredVertexCount) {
+        showError("vertex '" + words.at(i) + "' is inconsistent with declared vertex count '" + to_string(tdDeclaredVertexCount) + "' -- line " + to_string(lineIndex));
+      }
+      tdBags.at(bagIndex).push_back(cnfVar);
+    }
+    tdReadBagCount++;
+  }
+  else { // edge line
+    if (words.size() != 2) {
+      showError("edge line " + to_string(lineIndex) + " has " + to_string(words.size()) + " words (should be 2)");
+    }
+    Int bagIndex1 = std::stoll(words.at(0)) - 1;
+    Int bagIndex2 = std::stoll(words.at(1)) - 1;
+    if (bagIndex1 < 0 || bagIndex1 >= bagCount || bagIndex2 < 0 || bagIndex2 >= bagCount) {
+      showError("wrong edge -- line " + to_string(lineIndex));
+    }
+    tdEdges.push_back({bagIndex1, bagIndex2});
+  }
+
+  if (tdReadBagCount == bagCount && tdEdges.size() == bagCount - 1) {
+    finishReadingTreeDecomposition();
+  }
+}
+
+void JoinTreeReader::finishReadingTreeDecomposition() {
+  Int bagCount = tdBags.size();
+  vector<vector<Int>> neighbors(bagCount);
+  for (const std::pair<Int, Int> &edge : tdEdges) {
+    neighbors.at(edge.first).push_back(edge.second);
+    neighbors.at(edge.second).push_back(edge.first);
+  }
+
+  vector<Int> parents(bagCount, DUMMY_MIN_INT);
+  vector<Int> preorder; // parents before children; first bag is root
+  vector<Int> stack = {0};
+  parents.at(0) = DUMMY_MAX_INT;
+  while (!stack.empty()) {
+    Int bagIndex = stack.back();
+    stack.pop_back();
+    preorder.push_back(bagIndex);
+    for (Int neighbor : neighbors.at(bagIndex)) {
+      if (parents.at(neighbor) == DUMMY_MIN_INT) {
+        parents.at(neighbor) = bagIndex;
+        stack.push_back(neighbor);
       }
-      problemLineIndex = lineIndex;
+    }
+  }
+  if (preorder.size() != bagCount) {
+    showError("tree decomposition ending on line " + to_string(lineIndex) + " is disconnected");
+  }
 
-      if (wordCount != 5) {
-        showError("problem line " + to_string(lineIndex) + " has " + to_string(wordCount) + " words (should be 5)");
+  Map<Int, Int> highestBags; // cnfVar |-> bagIndex
+  Map<Int, vector<Int>> varBags; // cnfVar |-> bagIndexes
+  vector<Set<Int>> bagVarSets(bagCount);
+  for (Int bagIndex : preorder) {
+    for (Int cnfVar : tdBags.at(bagIndex)) {
+      highestBags.insert({cnfVar, bagIndex}); // keeps first
+      varBags[cnfVar].push_back(bagIndex);
+      bagVarSets.at(bagIndex).insert(cnfVar);
+    }
+  }
+
+  Int clauseCount = clauses->size();
+  vector<vector<Int>> bagClauses(bagCount);
+  Set<Int> clauseCnfVars;
+  for (Int clauseIndex = 0; clauseIndex < clauseCount; clauseIndex++) {
+    Set<Int> cnfVars = util::getClauseCnfVars(clauses->at(clauseIndex));
+    util::unionize(clauseCnfVars, cnfVars);
+
+    const vector<Int> *candidateBags = nullptr; // of var in fewest bags
+    for (Int cnfVar : cnfVars) {
+      auto it = varBags.find(cnfVar);
+      if (it == varBags.end()) {
+        showError("no bag contains var " + to_string(cnfVar) + " of clause " + to_string(clauseIndex + 1) + " (1-indexing)");
       }
-      const string &jtWord = words.at(1);
-      if (jtWord != JT_WORD) {
-        showError("expected '" + JT_WORD + "', found '" + jtWord + "' -- line " + to_string(lineIndex));
+      if (candidateBags == nullptr || it->second.size() < candidateBags->size()) {
+        candidateBags = &it->second;
       }
+    }
 
-      Int declaredVarCount = std::stoll(words.at(2));
-      Int declaredClauseCount = std::stoll(words.at(3));
-      Int declaredNodeCount = std::stoll(words.at(4));
+    if (candidateBags == nullptr) { // empty clause
+      bagClauses.at(0).push_back(clauseIndex);
+      continue;
+    }
 
-      backupJoinTree = joinTree;
-      joinTree = new JoinTree(declaredVarCount, declaredClauseCount, declaredNodeCount);
+    Int coveringBag = DUMMY_MIN_INT;
+    for (Int bagIndex : *candidateBags) {
+      const Set<Int> &bagVars = bagVarSets.at(bagIndex);
+      if (std::all_of(cnfVars.begin(), cnfVars.end(), [&bagVars](Int cnfVar) { return util::isFound(cnfVar, bagVars); })) {
+        coveringBag = bagIndex;
+        break;
+      }
+    }
+    if (coveringBag == DUMMY_MIN_INT) {
+      showError("no bag covers clause " + to_string(clauseIndex + 1) + " (1-indexing)");
+    }
+    bagClauses.at(coveringBag).push_back(clauseIndex);
+  }
 
-      JoinNode::resetStaticFields();
-      for (Int terminalIndex = 0; terminalIndex < declaredClauseCount; terminalIndex++) {
-        joinTree->joinTerminals[terminalIndex] = new JoinTerminal();
+  startJoinTree(tdDeclaredVertexCount, clauseCount, clauseCount + bagCount);
+
+  vector<vector<Int>> bagChildren(bagCount);
+  for (auto it = preorder.rbegin(); it != preorder.rend(); it++) { // children before parents; root last
+    Int bagIndex = *it;
+    vector<Int> &children = bagChildren.at(bagIndex);
+    children.insert(children.end(), bagClauses.at(bagIndex).begin(), bagClauses.at(bagIndex).end()); // terminal index is clause index
+
+    Set<Int> projectableCnfVars;
+    for (Int cnfVar : tdBags.at(bagIndex)) {
+      if (highestBags.at(cnfVar) == bagIndex && util::isFound(cnfVar, clauseCnfVars)) {
+        projectableCnfVars.insert(cnfVar);
       }
     }
-    else if (startWord == COMMENT_WORD) {
-      if (wordCount == 3) { // possibly LG
-        const string &key = words.at(1);
-        const string &value = words.at(2);
-        if (key == "pid") {
-          JoinTreeReader::plannerPid = std::stoll(value);
+
+    Int nodeIndex = joinTree->addNonterminal(children, projectableCnfVars, clauseCount + joinTree->nonterminalCount);
+    if (bagIndex != 0) {
+      bagChildren.at(parents.at(bagIndex)).push_back(nodeIndex);
+    }
+  }
+
+  tdSolutionLineIndex = DUMMY_MIN_INT;
+  finishReadingJoinTree();
+}
+
+void JoinTreeReader::readLine(const string &line) {
+  lineIndex++;
+  std::istringstream inputStringStream(line);
+
+  if (verbosityLevel >= 4) printComment("Line " + to_string(lineIndex) + "\t" + line);
+
+  vector<string> words;
+  std::copy(std::istream_iterator<string>(inputStringStream), std::istream_iterator<string>(), std::back_inserter(words));
+
+  Int wordCount = words.size();
+  if (wordCount < 1) return;
+  const string &startWord = words.at(0);
+
+  bool readingElimVars = false;
+  if (startWord == JOIN_TREE_END_WORD) {
+    finishReadingJoinTree();
+  }
+  else if (startWord == PROBLEM_WORD) {
+    if (problemLineIndex != DUMMY_MIN_INT) {
+      showError("multiple problem lines: " + to_string(problemLineIndex) + " and " + to_string(lineIndex));
+    }
+    problemLineIndex = lineIndex;
+
+    if (wordCount != 5) {
+      showError("problem line " + to_string(lineIndex) + " has " + to_string(wordCount) + " words (should be 5)");
+    }
+    const string &jtWord = words.at(1);
+    if (jtWord != JT_WORD) {
+      showError("expected '" + JT_WORD + "', found '" + jtWord + "' -- line " + to_string(lineIndex));
+    }
+
+    Int declaredVarCount = std::stoll(words.at(2));
+    Int declaredClauseCount = std::stoll(words.at(3));
+    Int declaredNodeCount = std::stoll(words.at(4));
+
+    startJoinTree(declaredVarCount, declaredClauseCount, declaredNodeCount);
+    tdSolutionLineIndex = DUMMY_MIN_INT;
+  }
+  else if (startWord == TD_SOLUTION_WORD) {
+    startReadingTreeDecomposition(words);
+  }
+  else if (startWord == COMMENT_WORD) {
+    if (wordCount == 3) { // possibly LG
+      const string &key = words.at(1);
+      const string &value = words.at(2);
+      if (key == "pid") {
+        if (!plannerSpawned) {
+          plannerPid = std::stoll(value);
         }
-        else if (key == "seconds") {
-          if (joinTree != nullptr) {
-            joinTree->plannerSeconds = std::stod(value);
-          }
+      }
+      else if (key == "seconds") {
+        if (joinTree != nullptr) {
+          joinTree->plannerSeconds = std::stod(value);
         }
       }
     }
-    else { // branch node line
-      if (problemLineIndex == DUMMY_MIN_INT) {
-        string message = "no problem line before branch node line " + to_string(lineIndex);
-        if (joinTreeEndLineIndex != DUMMY_MIN_INT) {
-          message += " (last legal join tree ends on line " + to_string(joinTreeEndLineIndex) + ")";
-        }
-        showError(message);
+  }
+  else if (tdSolutionLineIndex != DUMMY_MIN_INT) {
+    readTreeDecompositionLine(words);
+  }
+  else { // branch node line
+    if (problemLineIndex == DUMMY_MIN_INT) {
+      string message = "no problem line before branch node line " + to_string(lineIndex);
+      if (joinTreeEndLineIndex != DUMMY_MIN_INT) {
+        message += " (last legal join tree ends on line " + to_string(joinTreeEndLineIndex) + ")";
       }
+      showError(message);
+    }
 
-      Int parentIndex = std::stoll(startWord) - 1; // 0-indexing
-      if (parentIndex < joinTree->declaredClauseCount || parentIndex >= joinTree->declaredNodeCount) {
-        showError("wrong branch node index -- line " + to_string(lineIndex));
-      }
+    Int parentIndex = std::stoll(startWord) - 1; // 0-indexing
+    if (parentIndex < joinTree->declaredClauseCount || parentIndex >= joinTree->declaredNodeCount) {
+      showError("wrong branch node index -- line " + to_string(lineIndex));
+    }
 
-      vector<JoinNode *> children;
-      Set<Int> projectableCnfVars;
-      for (Int i = 1; i < wordCount; i++) {
-        const string &word = words.at(i);
-        if (word == VAR_ELIM_WORD) {
-          readingElimVars = true;
+    vector<Int> children;
+    Set<Int> projectableCnfVars;
+    for (Int i = 1; i < wordCount; i++) {
+      const string &word = words.at(i);
+      if (word == VAR_ELIM_WORD) {
+        readingElimVars = true;
+      }
+      else {
+        Int num = std::stoll(word);
+        if (readingElimVars) {
+          Int declaredVarCount = joinTree->declaredVarCount;
+          if (num <= 0 || num > declaredVarCount) {
+            showError("var '" + to_string(num) + "' is inconsistent with declared var count '" + to_string(declaredVarCount) + "' -- line " + to_string(lineIndex));
+          }
+          projectableCnfVars.insert(num);
         }
         else {
-          Int num = std::stoll(word);
-          if (readingElimVars) {
-            Int declaredVarCount = joinTree->declaredVarCount;
-            if (num <= 0 || num > declaredVarCount) {
-              showError("var '" + to_string(num) + "' is inconsistent with declared var count '" + to_string(declaredVarCount) + "' -- line " + to_string(lineIndex));
-            }
-            projectableCnfVars.insert(num);
-          }
-          else {
-            int childIndex = num - 1; // 0-indexing
-            if (childIndex < 0 || childIndex >= parentIndex) {
-              showError("child '" + word + "' is wrong -- line " + to_string(lineIndex));
-            }
-            children.push_back(joinTree->getJoinNode(childIndex));
+          int childIndex = num - 1; // 0-indexing
+          if (childIndex < 0 || childIndex >= parentIndex) {
+            showError("child '" + word + "' is wrong -- line " + to_string(lineIndex));
           }
+          children.push_back(childIndex);
         }
       }
-      joinTree->joinNonterminals[parentIndex] = new JoinNonterminal(children, projectableCnfVars, parentIndex);
     }
+    joinTree->addNonterminal(children, projectableCnfVars, parentIndex);
+  }
+}
+
+void JoinTreeReader::readInputStream(std::istream *inputStream) {
+  string line;
+  while (std::getline(*inputStream, line)) {
+    readLine(line);
+  }
+
+  finishReadingJoinTree();
+}
+
+void JoinTreeReader::readBinaryFile(const string &filePath) {
+  int fd = open(filePath.c_str(), O_RDONLY);
+  struct stat fileStat;
+  if (fd < 0 || fstat(fd, &fileStat) != 0) {
+    showError("unable to open file '" + filePath + "'");
+  }
+  size_t fileSize = fileStat.st_size;
+  if (fileSize < sizeof(BinaryJoinTreeHeader)) {
+    showError("binary jt file '" + filePath + "' is truncated");
+  }
+  void *data = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    showError("unable to map file '" + filePath + "'");
+  }
+
+  const BinaryJoinTreeHeader *header = static_cast<const BinaryJoinTreeHeader *>(data);
+  if (string(header->magic, sizeof(header->magic)) != BINARY_JOIN_TREE_MAGIC || header->version != BINARY_JOIN_TREE_VERSION) {
+    showError("binary jt file '" + filePath + "' has wrong magic or version (expected version " + to_string(BINARY_JOIN_TREE_VERSION) + ")");
+  }
+  Int clauseCount = header->clauseCount;
+  Int nonterminalCount = header->nonterminalCount;
+  if (clauseCount < 0 || nonterminalCount < 1 || clauseCount != clauses->size()) {
+    showError("binary jt file '" + filePath + "' has " + to_string(clauseCount) + " clauses and " + to_string(nonterminalCount) + " nonterminals (cnf has " + to_string(clauses->size()) + " clauses)");
+  }
+
+  Int maxArrayLength = fileSize / sizeof(int64_t); // bounds counts from header before they are multiplied
+  if (nonterminalCount >= maxArrayLength) {
+    showError("binary jt file '" + filePath + "' has wrong size");
+  }
+
+  const int64_t *childOffsets = reinterpret_cast<const int64_t *>(header + 1);
+  const int64_t *elimVarOffsets = childOffsets + nonterminalCount + 1;
+  const int64_t *children = elimVarOffsets + nonterminalCount + 1;
+  size_t spanSize = sizeof(BinaryJoinTreeHeader) + 2 * (nonterminalCount + 1) * sizeof(int64_t);
+  if (fileSize < spanSize || childOffsets[0] != 0 || elimVarOffsets[0] != 0) {
+    showError("binary jt file '" + filePath + "' has wrong spans");
+  }
+  Int childCount = childOffsets[nonterminalCount];
+  Int elimVarCount = elimVarOffsets[nonterminalCount];
+  if (childCount < 0 || elimVarCount < 0 || childCount > maxArrayLength || elimVarCount > maxArrayLength || fileSize != spanSize + (childCount + elimVarCount) * sizeof(int64_t)) {
+    showError("binary jt file '" + filePath + "' has wrong size");
+  }
+  const int64_t *elimVars = children + childCount;
+
+  startJoinTree(header->declaredVarCount, clauseCount, clauseCount + nonterminalCount);
+  for (Int i = 0; i < nonterminalCount; i++) {
+    Int nodeIndex = clauseCount + i;
+    if (childOffsets[i] > childOffsets[i + 1] || childOffsets[i + 1] > childCount || elimVarOffsets[i] > elimVarOffsets[i + 1] || elimVarOffsets[i + 1] > elimVarCount) {
+      showError("binary jt file '" + filePath + "' has wrong spans for node " + to_string(nodeIndex + 1));
+    }
+
+    vector<Int> nodeChildren(children + childOffsets[i], children + childOffsets[i + 1]);
+    for (Int childIndex : nodeChildren) {
+      if (childIndex < 0 || childIndex >= nodeIndex) {
+        showError("binary jt file '" + filePath + "' has wrong child for node " + to_string(nodeIndex + 1));
+      }
+    }
+
+    Set<Int> projectableCnfVars;
+    for (Int j = elimVarOffsets[i]; j < elimVarOffsets[i + 1]; j++) {
+      if (elimVars[j] <= 0 || elimVars[j] > header->declaredVarCount) {
+        showError("binary jt file '" + filePath + "' has wrong var for node " + to_string(nodeIndex + 1));
+      }
+      projectableCnfVars.insert(elimVars[j]);
+    }
+
+    joinTree->addNonterminal(nodeChildren, projectableCnfVars, nodeIndex);
   }
+  binaryCnfHashes = HashPair(header->cnfHashes[0], header->cnfHashes[1]);
 
+  munmap(data, fileSize);
   finishReadingJoinTree();
 }
 
-JoinNonterminal *JoinTreeReader::getJoinTreeRoot() const {
-  return joinTree->getJoinRoot();
+Float JoinTreeReader::getPlanningDeadlineSeconds() const {
+  Float bestSeconds = getBestCountingSeconds();
+  if (jtAdaptiveFactor <= 0 || std::isinf(bestSeconds)) {
+    return jtWaitSeconds;
+  }
+  return std::max(jtMinWaitSeconds, std::min(jtWaitSeconds, jtAdaptiveFactor * bestSeconds)); // more planning saves at most remaining counting time
+}
+
+void JoinTreeReader::readFileDescriptor(int inputFd, int plannerInputFd, const string &plannerInput) {
+  if (plannerInputFd >= 0) {
+    fcntl(plannerInputFd, F_SETFL, fcntl(plannerInputFd, F_GETFL) | O_NONBLOCK); // planner may print before reading all input
+  }
+
+  Float graceDeadlineSeconds = NEGATIVE_INFINITY; // set when planner gets SIGTERM and may print last join tree
+  size_t writtenSize = 0;
+  string buffer;
+  char chunk[1 << 16];
+  while (true) {
+    if (isStoppingRequested()) { // counting is done
+      if (plannerInputFd >= 0) close(plannerInputFd);
+      if (inputFd != STDIN_FILENO) close(inputFd);
+      if (!plannerSpawned && plannerPid != DUMMY_MIN_INT) kill(plannerPid, SIGTERM);
+      terminatePlanner();
+      return;
+    }
+
+    Float elapsedSeconds = util::getSeconds(readingStartTime);
+    Float remainingSeconds = (graceDeadlineSeconds >= 0 ? graceDeadlineSeconds : getPlanningDeadlineSeconds()) - elapsedSeconds;
+    if (remainingSeconds <= 0) {
+      if (graceDeadlineSeconds >= 0) break;
+      if (elapsedSeconds < jtWaitSeconds) {
+        printComment("Stopping planning after " + to_string(elapsedSeconds) + " seconds (best join tree predicts " + to_string(getBestCountingSeconds()) + " counting seconds)", 1);
+      }
+      if (plannerPid == DUMMY_MIN_INT) break;
+      if (elapsedSeconds >= jtWaitSeconds) {
+        showWarning("terminating planner process with PID " + to_string(plannerPid) + " after " + to_string(jtWaitSeconds) + " seconds");
+      }
+      kill(plannerPid, SIGTERM);
+      graceDeadlineSeconds = elapsedSeconds + PLANNER_GRACE_SECONDS;
+      continue;
+    }
+
+    pollfd pollFds[2] = {{inputFd, POLLIN, 0}, {plannerInputFd, POLLOUT, 0}};
+    nfds_t pollFdCount = plannerInputFd >= 0 ? 2 : 1;
+    int pollMilliseconds = std::min((Int)std::ceil(remainingSeconds * 1000), PLANNER_POLL_MILLISECONDS);
+    if (poll(pollFds, pollFdCount, pollMilliseconds) < 0) {
+      if (errno == EINTR) continue;
+      showError("failed to poll planner output");
+    }
+
+    if (pollFdCount == 2 && pollFds[1].revents != 0) {
+      ssize_t size = write(plannerInputFd, plannerInput.data() + writtenSize, plannerInput.size() - writtenSize);
+      if (size > 0) writtenSize += size;
+      if (writtenSize == plannerInput.size() || (size < 0 && errno != EAGAIN && errno != EINTR)) { // done or planner stopped reading
+        close(plannerInputFd); // planner gets end of file
+        plannerInputFd = -1;
+      }
+    }
+
+    if (pollFds[0].revents != 0) {
+      ssize_t size = read(inputFd, chunk, sizeof(chunk));
+      if (size < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+      if (size <= 0) break; // end of file
+      buffer.append(chunk, size);
+      size_t lineStart = 0;
+      for (size_t lineEnd = buffer.find('\n'); lineEnd != string::npos; lineEnd = buffer.find('\n', lineStart)) {
+        readLine(buffer.substr(lineStart, lineEnd - lineStart));
+        lineStart = lineEnd + 1;
+      }
+      buffer.erase(0, lineStart);
+    }
+  }
+
+  if (!buffer.empty()) readLine(buffer); // last line without newline
+  if (plannerInputFd >= 0) close(plannerInputFd);
+  if (inputFd != STDIN_FILENO) close(inputFd);
+  terminatePlanner();
+
+  if (joinTree == nullptr && plannerSpawned) {
+    showError("planner '" + plannerCommand + "' printed no join tree");
+  }
+  finishReadingJoinTree();
+}
+
+void JoinTreeReader::readSafely(const std::function<void()> &reading) {
+  try {
+    reading();
+    finishReading(false);
+  }
+  catch (const MyError &) { // already printed
+    finishReading(true);
+  }
+}
+
+void JoinTreeReader::startReading(const std::function<void()> &reading, bool speculating) {
+  readingStartTime = util::getTimePoint();
+  if (speculating) { // counting starts on first legal join tree while later ones are read
+    readingThread = std::thread(&JoinTreeReader::readSafely, this, reading);
+
+    std::unique_lock<std::mutex> lock(publishingMutex);
+    publishingCondition.wait(lock, [this] { return publishedJoinTree != nullptr || readingFinished; });
+    if (publishedJoinTree == nullptr) {
+      lock.unlock();
+      readingThread.join();
+      showError("no legal join tree");
+    }
+  }
+  else {
+    reading();
+    finishReading(false);
+  }
+}
+
+void JoinTreeReader::spawnPlanner(int &plannerInputFd, int &plannerOutputFd) {
+  vector<string> words = getCommandWords(plannerCommand);
+  if (words.empty()) {
+    showError("empty planner command");
+  }
+  vector<char *> argv;
+  for (string &word : words) argv.push_back(&word[0]);
+  argv.push_back(nullptr);
+
+  int inputPipe[2];
+  int outputPipe[2];
+  if (pipe2(inputPipe, O_CLOEXEC) != 0 || pipe2(outputPipe, O_CLOEXEC) != 0) {
+    showError("unable to create pipes for planner");
+  }
+
+  signal(SIGPIPE, SIG_IGN); // planner may exit before reading all input
+
+  pid_t pid = fork();
+  if (pid < 0) {
+    showError("unable to fork planner process");
+  }
+  if (pid == 0) { // child
+    dup2(inputPipe[0], STDIN_FILENO); // clears O_CLOEXEC
+    dup2(outputPipe[1], STDOUT_FILENO);
+    execvp(argv.at(0), argv.data());
+    std::cerr << "c unable to execute planner '" << words.at(0) << "'\n";
+    _exit(127);
+  }
+
+  close(inputPipe[0]);
+  close(outputPipe[1]);
+  plannerInputFd = inputPipe[1];
+  plannerOutputFd = outputPipe[0];
+  plannerPid = pid;
+  plannerSpawned = true;
+
+  if (verbosityLevel >= 1) {
+    util::printRow("plannerPid", plannerPid);
+  }
+}
+
+void JoinTreeReader::terminatePlanner() {
+  if (!plannerSpawned || plannerPid == DUMMY_MIN_INT) return;
+
+  int status;
+  if (waitpid(plannerPid, &status, WNOHANG) == 0) { // still running
+    kill(plannerPid, SIGTERM);
+    TimePoint terminatingTime = util::getTimePoint();
+    while (waitpid(plannerPid, &status, WNOHANG) == 0) {
+      if (util::getSeconds(terminatingTime) >= PLANNER_GRACE_SECONDS) {
+        kill(plannerPid, SIGKILL);
+        waitpid(plannerPid, &status, 0);
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(PLANNER_POLL_MILLISECONDS / 10));
+    }
+  }
+  plannerPid = DUMMY_MIN_INT;
+}
+
+void JoinTreeReader::printFirstJoinTreeInfo() const {
+  if (verbosityLevel >= 1) {
+    JoinTree *firstJoinTree;
+    {
+      std::lock_guard<std::mutex> lock(publishingMutex);
+      firstJoinTree = publishedJoinTree;
+    }
+    util::printRow("declaredVarCount", firstJoinTree->declaredVarCount);
+    util::printRow("declaredClauseCount", firstJoinTree->declaredClauseCount);
+    util::printRow("declaredNodeCount", firstJoinTree->declaredNodeCount);
+    util::printRow("plannerSeconds", firstJoinTree->plannerSeconds);
+  }
+}
+
+JoinNode *JoinTreeReader::getJoinTreeRoot() const {
+  Int joinTreeCount;
+  return getJoinTreeRoot(joinTreeCount);
+}
+
+JoinNode *JoinTreeReader::getJoinTreeRoot(Int &joinTreeCount) const {
+  std::lock_guard<std::mutex> lock(publishingMutex);
+  joinTreeCount = publishedJoinTreeCount;
+  return publishedJoinTree->getJoinRoot();
 }
 
-JoinTreeReader::JoinTreeReader(const string &filePath, Float jtWaitSeconds) {
+bool JoinTreeReader::isBinaryFile(const string &filePath) {
+  std::ifstream inputFileStream(filePath, std::ios::binary);
+  string magic(BINARY_JOIN_TREE_MAGIC.size(), ' ');
+  inputFileStream.read(&magic[0], magic.size());
+  return inputFileStream.good() && magic == BINARY_JOIN_TREE_MAGIC;
+}
+
+void JoinTreeReader::writeBinaryFile(const string &filePath, JoinNode *joinRoot, Int declaredVarCount, Int clauseCount, const HashPair &cnfHashes) {
+  vector<JoinNode *> postorder = joinRoot->getPostorder();
+
+  Map<Int, Int> binaryIndexes; // nodeIndex |-> index in binary file
+  vector<int64_t> childOffsets = {0};
+  vector<int64_t> elimVarOffsets = {0};
+  vector<int64_t> children;
+  vector<int64_t> elimVars;
+  for (JoinNode *joinNode : postorder) {
+    for (JoinNode *child : joinNode->getChildren()) {
+      children.push_back(child->isTerminal() ? child->getNodeIndex() : binaryIndexes.at(child->getNodeIndex()));
+    }
+    vector<Int> projectableCnfVars(joinNode->getProjectableCnfVars().begin(), joinNode->getProjectableCnfVars().end());
+    std::sort(projectableCnfVars.begin(), projectableCnfVars.end());
+    elimVars.insert(elimVars.end(), projectableCnfVars.begin(), projectableCnfVars.end());
+    childOffsets.push_back(children.size());
+    elimVarOffsets.push_back(elimVars.size());
+    Int binaryIndex = clauseCount + binaryIndexes.size();
+    binaryIndexes[joinNode->getNodeIndex()] = binaryIndex;
+  }
+
+  BinaryJoinTreeHeader header;
+  std::memcpy(header.magic, BINARY_JOIN_TREE_MAGIC.data(), sizeof(header.magic));
+  header.version = BINARY_JOIN_TREE_VERSION;
+  header.declaredVarCount = declaredVarCount;
+  header.clauseCount = clauseCount;
+  header.nonterminalCount = postorder.size();
+  header.cnfHashes[0] = cnfHashes.first;
+  header.cnfHashes[1] = cnfHashes.second;
+
+  string tempFilePath = filePath + ".tmp" + to_string(getpid());
+  std::ofstream outputFileStream(tempFilePath, std::ios::binary);
+  outputFileStream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  for (const vector<int64_t> *array : {&childOffsets, &elimVarOffsets, &children, &elimVars}) {
+    outputFileStream.write(reinterpret_cast<const char *>(array->data()), array->size() * sizeof(int64_t));
+  }
+  outputFileStream.close();
+  if (!outputFileStream || std::rename(tempFilePath.c_str(), filePath.c_str()) != 0) {
+    std::remove(tempFilePath.c_str());
+    showError("unable to write binary jt file '" + filePath + "'");
+  }
+}
+
+const HashPair &JoinTreeReader::getBinaryCnfHashes() const {
+  return binaryCnfHashes;
+}
+
+Float JoinTreeReader::getPlanningSeconds() const {
+  std::lock_guard<std::mutex> lock(publishingMutex);
+  return planningSeconds;
+}
+
+Float JoinTreeReader::getBestCountingSeconds() const {
+  std::lock_guard<std::mutex> lock(publishingMutex);
+  return bestCountingSeconds;
+}
+
+void JoinTreeReader::stopReading() {
+  if (!readingThread.joinable()) return;
+
+  {
+    std::lock_guard<std::mutex> lock(publishingMutex);
+    stoppingRequested = true;
+  }
+  readingThread.join();
+}
+
+JoinTreeReader::JoinTreeReader(const string &filePath, const vector<vector<Int>> &clauses, Float jtWaitSeconds, Float jtMinWaitSeconds, Float jtAdaptiveFactor, const CountingSecondsPredictor &predictCountingSeconds, bool speculating) {
   printComment("Reading join tree...", 1);
 
-  std::ifstream inputFileStream(filePath); // variable will be destroyed if it goes out of scope
-  std::istream *inputStream;
+  this->clauses = &clauses;
+  this->jtWaitSeconds = jtWaitSeconds;
+  this->jtMinWaitSeconds = jtMinWaitSeconds;
+  this->jtAdaptiveFactor = jtAdaptiveFactor;
+  this->predictCountingSeconds = predictCountingSeconds;
+
   if (filePath == STDIN_CONVENTION) {
-    inputStream = &std::cin;
+    printThickLine();
+    printComment("Getting join tree from stdin with " + to_string(jtWaitSeconds) + "-second timeout... (end input with 'Enter' then 'Ctrl d')");
 
-    signal(SIGALRM, handleAlarm); // installs handler
-    alarm(jtWaitSeconds); // schedules signal
+    startReading([this] { readFileDescriptor(STDIN_FILENO, -1, ""); }, speculating);
 
+    printComment(speculating ? "Getting join tree from stdin: first legal join tree found" : "Getting join tree from stdin: done");
     printThickLine();
-    printComment("Getting join tree from stdin with " + to_string(jtWaitSeconds) + "-second timeout... (end input with 'Enter' then 'Ctrl d')");
+  }
+  else if (isBinaryFile(filePath)) {
+    startReading([this, filePath] { readBinaryFile(filePath); }, false); // nothing to speculate on
   }
   else {
+    inputFileStream.open(filePath);
     if (!inputFileStream.is_open()) {
       showError("unable to open file '" + filePath + "'");
     }
-    inputStream = &inputFileStream;
+    startReading([this] { readInputStream(&inputFileStream); }, speculating);
   }
 
-  readInputStream(inputStream);
+  printFirstJoinTreeInfo();
+}
+
+JoinTreeReader::JoinTreeReader(const string &plannerCommand, const string &plannerInput, const vector<vector<Int>> &clauses, Float jtWaitSeconds, Float jtMinWaitSeconds, Float jtAdaptiveFactor, const CountingSecondsPredictor &predictCountingSeconds, bool speculating) {
+  printComment("Planning join tree...", 1);
 
-  if (filePath == STDIN_CONVENTION) {
-    printComment("Getting join tree from stdin: done");
-    printThickLine();
-  }
+  this->clauses = &clauses;
+  this->plannerCommand = plannerCommand;
+  this->jtWaitSeconds = jtWaitSeconds;
+  this->jtMinWaitSeconds = jtMinWaitSeconds;
+  this->jtAdaptiveFactor = jtAdaptiveFactor;
+  this->predictCountingSeconds = predictCountingSeconds;
+  int plannerInputFd;
+  int plannerOutputFd;
+  spawnPlanner(plannerInputFd, plannerOutputFd);
 
-  if (verbosityLevel >= 1) {
-    util::printRow("declaredVarCount", joinTree->declaredVarCount);
-    util::printRow("declaredClauseCount", joinTree->declaredClauseCount);
-    util::printRow("declaredNodeCount", joinTree->declaredNodeCount);
-    util::printRow("plannerSeconds", joinTree->plannerSeconds);
+  startReading([this, plannerOutputFd, plannerInputFd, plannerInput] { readFileDescriptor(plannerOutputFd, plannerInputFd, plannerInput); }, speculating);
+
+  printFirstJoinTreeInfo();
+}
+
+JoinTreeReader::~JoinTreeReader() {
+  stopReading();
+  for (JoinTree *startedJoinTree : startedJoinTrees) {
+    delete startedJoinTree;
   }
 }
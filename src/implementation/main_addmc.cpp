@@ -12,13 +12,37 @@ void OptionDict::printOptionalOptions() const {
   util::printCnfFileOption();
   util::printWeightFormatOption();
   // util::printJtFileOption();
+  // util::printJtPlannerOption();
+  // util::printJtPlannerGraphOption();
   // util::printJtWaitOption();
+  // util::printJtMinWaitOption();
+  // util::printJtAdaptiveWaitOption();
+  // util::printJtRestartOption();
+  // util::printJtBinaryOutputOption();
   // util::printOutputFormatOption();
   util::printClusteringHeuristicOption();
   util::printCnfVarOrderingHeuristicOption();
   util::printDdVarOrderingHeuristicOption();
   util::printRandomSeedOption();
   util::printVerbosityLevelOption();
+  util::printSubformulaCachingOption();
+  util::printResultCacheDirOption();
+  util::printResultCacheMegabytesOption();
+  util::printResultCacheComponentsOption();
+  util::printCheckpointDirOption();
+  util::printCheckpointSecondsOption();
+  util::printCheckpointResumeOption();
+  util::printSpillDirOption();
+  util::printSpillMegabytesOption();
+  util::printExactCountingOption();
+  util::printExtendedRangeOption();
+  util::printEpsilonOption();
+  util::printMarginalsOption();
+  util::printQueryVarsOption();
+  util::printQueryFileOption();
+  util::printSemiringOption();
+  util::printLocalDdVarsOption();
+  util::printMultiplicationScheduleOption();
 }
 
 void OptionDict::printHelp() const {
@@ -51,13 +75,37 @@ OptionDict::OptionDict(int argc, char *argv[]) {
     (CNF_FILE_OPTION, "", cxxopts::value<string>()->default_value(STDIN_CONVENTION))
     (WEIGHT_FORMAT_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_WEIGHT_FORMAT_CHOICE)))
     (JT_FILE_OPTION, "", cxxopts::value<string>()->default_value(DUMMY_STR))
+    (JT_PLANNER_OPTION, "", cxxopts::value<string>()->default_value(DUMMY_STR))
+    (JT_PLANNER_GRAPH_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_JT_PLANNER_GRAPH_CHOICE)))
     (JT_WAIT_DURAION_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_JT_WAIT_SECONDS)))
+    (JT_MIN_WAIT_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_JT_MIN_WAIT_SECONDS)))
+    (JT_ADAPTIVE_WAIT_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_JT_ADAPTIVE_FACTOR)))
+    (JT_RESTART_RATIO_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_JT_RESTART_RATIO)))
+    (JT_BINARY_OUTPUT_OPTION, "", cxxopts::value<string>()->default_value(DUMMY_STR))
     (OUTPUT_FORMAT_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_OUTPUT_FORMAT_CHOICE)))
     (CLUSTERING_HEURISTIC_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_CLUSTERING_HEURISTIC_CHOICE)))
     (CLUSTER_VAR_ORDER_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_CNF_VAR_ORDERING_HEURISTIC_CHOICE)))
     (DIAGRAM_VAR_ORDER_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_DD_VAR_ORDERING_HEURISTIC_CHOICE)))
     (RANDOM_SEED_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_RANDOM_SEED)))
     (VERBOSITY_LEVEL_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_VERBOSITY_LEVEL_CHOICE)))
+    (SUBFORMULA_CACHING_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_SUBFORMULA_CACHING_CHOICE)))
+    (RESULT_CACHE_DIR_OPTION, "", cxxopts::value<string>()->default_value(DUMMY_STR))
+    (RESULT_CACHE_MEGABYTES_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_RESULT_CACHE_MEGABYTES)))
+    (RESULT_CACHE_COMPONENTS_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_RESULT_CACHE_COMPONENTS_CHOICE)))
+    (CHECKPOINT_DIR_OPTION, "", cxxopts::value<string>()->default_value(DUMMY_STR))
+    (CHECKPOINT_SECONDS_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_CHECKPOINT_SECONDS)))
+    (CHECKPOINT_RESUME_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_CHECKPOINT_RESUME_CHOICE)))
+    (SPILL_DIR_OPTION, "", cxxopts::value<string>()->default_value(DUMMY_STR))
+    (SPILL_MEGABYTES_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_SPILL_MEGABYTES)))
+    (EXACT_COUNTING_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_EXACT_COUNTING_CHOICE)))
+    (EXTENDED_RANGE_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_EXTENDED_RANGE_CHOICE)))
+    (EPSILON_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_EPSILON)))
+    (MARGINALS_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_MARGINALS_CHOICE)))
+    (QUERY_VARS_OPTION, "", cxxopts::value<string>()->default_value(DUMMY_STR))
+    (QUERY_FILE_OPTION, "", cxxopts::value<string>()->default_value(STDIN_CONVENTION))
+    (SEMIRING_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_SEMIRING_CHOICE)))
+    (LOCAL_DD_VARS_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_LOCAL_DD_VARS_CHOICE)))
+    (MULTIPLICATION_SCHEDULE_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_MULTIPLICATION_SCHEDULE_CHOICE)))
   ;
 
   cxxopts::ParseResult result = options->parse(argc, argv);
@@ -71,15 +119,70 @@ OptionDict::OptionDict(int argc, char *argv[]) {
   if (cnfFilePath == jtFilePath) {
     showError("options --" + CNF_FILE_OPTION + " and --" + JT_FILE_OPTION + " must have distinct args", !helpFlag);
   }
+  jtPlannerCommand = result[JT_PLANNER_OPTION].as<string>();
+  if (jtPlannerCommand != DUMMY_STR && jtFilePath != DUMMY_STR) {
+    showError("options --" + JT_FILE_OPTION + " and --" + JT_PLANNER_OPTION + " are mutually exclusive", !helpFlag);
+  }
 
   weightFormatOption = std::stoll(result[WEIGHT_FORMAT_OPTION].as<string>());
+  jtPlannerGraphOption = std::stoll(result[JT_PLANNER_GRAPH_OPTION].as<string>());
   jtWaitSeconds = std::stod(result[JT_WAIT_DURAION_OPTION].as<string>());
+  jtMinWaitSeconds = std::stod(result[JT_MIN_WAIT_OPTION].as<string>());
+  jtAdaptiveFactor = std::stod(result[JT_ADAPTIVE_WAIT_OPTION].as<string>());
+  jtRestartRatio = std::stod(result[JT_RESTART_RATIO_OPTION].as<string>());
   outputFormatOption = std::stoll(result[OUTPUT_FORMAT_OPTION].as<string>());
   clusteringHeuristicOption = std::stoll(result[CLUSTERING_HEURISTIC_OPTION].as<string>());
   cnfVarOrderingHeuristicOption = std::stoll(result[CLUSTER_VAR_ORDER_OPTION].as<string>());
   ddVarOrderingHeuristicOption = std::stoll(result[DIAGRAM_VAR_ORDER_OPTION].as<string>());
   randomSeedOption = std::stoll(result[RANDOM_SEED_OPTION].as<string>());
   verbosityLevelOption = std::stoll(result[VERBOSITY_LEVEL_OPTION].as<string>());
+  subformulaCachingOption = std::stoll(result[SUBFORMULA_CACHING_OPTION].as<string>());
+  resultCacheDirOption = result[RESULT_CACHE_DIR_OPTION].as<string>();
+  resultCacheMegabytesOption = std::stod(result[RESULT_CACHE_MEGABYTES_OPTION].as<string>());
+  resultCacheComponentsOption = std::stoll(result[RESULT_CACHE_COMPONENTS_OPTION].as<string>());
+  checkpointDirOption = result[CHECKPOINT_DIR_OPTION].as<string>();
+  checkpointSecondsOption = std::stod(result[CHECKPOINT_SECONDS_OPTION].as<string>());
+  checkpointResumeOption = std::stoll(result[CHECKPOINT_RESUME_OPTION].as<string>());
+  spillDirOption = result[SPILL_DIR_OPTION].as<string>();
+  spillMegabytesOption = std::stod(result[SPILL_MEGABYTES_OPTION].as<string>());
+  exactCountingOption = std::stoll(result[EXACT_COUNTING_OPTION].as<string>());
+  extendedRangeOption = std::stoll(result[EXTENDED_RANGE_OPTION].as<string>());
+  epsilonOption = std::stod(result[EPSILON_OPTION].as<string>());
+  if (epsilonOption < 0 || epsilonOption >= 1) {
+    showError("option --" + EPSILON_OPTION + " must be in [0, 1)", !helpFlag);
+  }
+  marginalsOption = std::stoll(result[MARGINALS_OPTION].as<string>());
+  if (marginalsOption != 0 && (exactCountingOption != 0 || extendedRangeOption != 0 || epsilonOption > 0)) {
+    showError("option --" + MARGINALS_OPTION + " excludes --" + EXACT_COUNTING_OPTION + ", --" + EXTENDED_RANGE_OPTION + ", and --" + EPSILON_OPTION, !helpFlag);
+  }
+  queryVarsOption = result[QUERY_VARS_OPTION].as<string>();
+  queryFileOption = result[QUERY_FILE_OPTION].as<string>();
+  if (queryVarsOption != DUMMY_STR) {
+    if (marginalsOption != 0 || exactCountingOption != 0 || epsilonOption > 0) {
+      showError("option --" + QUERY_VARS_OPTION + " excludes --" + MARGINALS_OPTION + ", --" + EXACT_COUNTING_OPTION + ", and --" + EPSILON_OPTION, !helpFlag);
+    }
+    if (queryFileOption == cnfFilePath) {
+      showError("options --" + CNF_FILE_OPTION + " and --" + QUERY_FILE_OPTION + " must have distinct args", !helpFlag);
+    }
+  }
+  semiringOption = std::stoll(result[SEMIRING_OPTION].as<string>());
+  if (semiringOption != DEFAULT_SEMIRING_CHOICE && (marginalsOption != 0 || queryVarsOption != DUMMY_STR || exactCountingOption != 0)) {
+    showError("option --" + SEMIRING_OPTION + " other than " + to_string(DEFAULT_SEMIRING_CHOICE) + " excludes --" + MARGINALS_OPTION + ", --" + QUERY_VARS_OPTION + ", and --" + EXACT_COUNTING_OPTION, !helpFlag);
+  }
+  if (SEMIRING_CHOICES.find(semiringOption) != SEMIRING_CHOICES.end() && SEMIRING_CHOICES.at(semiringOption) == Semiring::LOG_SUM_EXP && epsilonOption > 0) {
+    showError("option --" + EPSILON_OPTION + " needs linear terminals, unlike log-sum-exp semiring", !helpFlag);
+  }
+  localDdVarsOption = std::stoll(result[LOCAL_DD_VARS_OPTION].as<string>());
+  if (localDdVarsOption != 0) {
+    if (jtFilePath == DUMMY_STR && jtPlannerCommand == DUMMY_STR) {
+      showError("option --" + LOCAL_DD_VARS_OPTION + " needs join tree from --" + JT_FILE_OPTION + " or --" + JT_PLANNER_OPTION, !helpFlag);
+    }
+    if (subformulaCachingOption != 0 || marginalsOption != 0 || queryVarsOption != DUMMY_STR) {
+      showError("option --" + LOCAL_DD_VARS_OPTION + " excludes --" + SUBFORMULA_CACHING_OPTION + ", --" + MARGINALS_OPTION + ", and --" + QUERY_VARS_OPTION, !helpFlag);
+    }
+  }
+  multiplicationScheduleOption = std::stoll(result[MULTIPLICATION_SCHEDULE_OPTION].as<string>());
+  binaryJtFileOption = result[JT_BINARY_OUTPUT_OPTION].as<string>();
 }
 
 /* namespaces *****************************************************************/
@@ -99,12 +202,12 @@ void testing::test() {
   BouquetCounter bouquetListCounter(false, cnfVarOrderingHeuristic, false, ddVarOrderingHeuristic, false);
   BouquetCounter bouquetTreeCounter(true, cnfVarOrderingHeuristic, false, ddVarOrderingHeuristic, false);
 
-  Float m = monolithicCounter.getModelCount(cnf);
-  Float l = linearCounter.getModelCount(cnf);
-  Float bel = bucketListCounter.getModelCount(cnf);
-  Float bet = bucketTreeCounter.getModelCount(cnf);
-  Float bml = bouquetListCounter.getModelCount(cnf);
-  Float bmt = bouquetTreeCounter.getModelCount(cnf);
+  Float m = monolithicCounter.getModelCount(cnf).toFloat();
+  Float l = linearCounter.getModelCount(cnf).toFloat();
+  Float bel = bucketListCounter.getModelCount(cnf).toFloat();
+  Float bet = bucketTreeCounter.getModelCount(cnf).toFloat();
+  Float bml = bouquetListCounter.getModelCount(cnf).toFloat();
+  Float bmt = bouquetTreeCounter.getModelCount(cnf).toFloat();
 
   vector<Float> counts = {m, l, bel, bet, bml, bmt};
   for (Int i = 0; i < counts.size(); i++) {
@@ -124,13 +227,309 @@ void testing::test() {
   cout << std::left << std::setw(30) << "bouquet tree model count" << bmt << "\n";
 }
 
+void testing::writeFile(const string &filePath, const string &text) {
+  std::ofstream outputFileStream(filePath);
+  outputFileStream << text;
+  if (!outputFileStream.good()) {
+    showError("unable to write file '" + filePath + "'");
+  }
+}
+
+void testing::removeDir(const string &dirPath) {
+  DIR *dir = opendir(dirPath.c_str());
+  if (dir == nullptr) return;
+  while (dirent *entry = readdir(dir)) {
+    string entryName = entry->d_name;
+    if (entryName == "." || entryName == "..") continue;
+    string entryPath = dirPath + "/" + entryName;
+    if (unlink(entryPath.c_str()) != 0) removeDir(entryPath); // subdir
+  }
+  closedir(dir);
+  rmdir(dirPath.c_str());
+}
+
+void testing::checkEqual(const string &actual, const string &expected, const string &description) {
+  if (actual != expected) {
+    showError(description + ": expected '" + expected + "', found '" + actual + "'");
+  }
+  printComment("Passed: " + description);
+}
+
+bool testing::isRejected(const std::function<void()> &action) {
+  try {
+    action();
+  }
+  catch (const MyError &) { // already printed
+    return true;
+  }
+  return false;
+}
+
+void testing::testDecimals() {
+  vector<std::pair<string, Decimal>> parsedWords = {{"0.25", {25, -2}}, {"1e-3", {1, -3}}, {"0.500000", {5, -1}}, {"-2.5", {-25, -1}}, {"120", {12, 1}}, {"0.0", {0, 0}}};
+  for (const auto &parsedWord : parsedWords) {
+    Decimal decimal;
+    bool parsed = util::parseDecimal(decimal, parsedWord.first);
+    checkEqual(parsed ? to_string(decimal.first) + "e" + to_string(decimal.second) : "unparsed", to_string(parsedWord.second.first) + "e" + to_string(parsedWord.second.second), "parseDecimal('" + parsedWord.first + "')");
+  }
+  for (const string &word : vector<string>{"", "abc", "1e", "1.2.3", "99999999999999999999"}) {
+    Decimal decimal;
+    checkEqual(util::parseDecimal(decimal, word) ? "parsed" : "unparsed", "unparsed", "parseDecimal('" + word + "')");
+  }
+
+  auto getResidue = [](const string &digits, Int modulus) { // of nonnegative integer too large for Int
+    Int residue = 0;
+    for (char digit : digits) residue = (residue * 10 + (digit - '0')) % modulus;
+    return residue;
+  };
+  vector<Int> moduli = util::getLargestPrimes(MAX_MODULUS, 4); // product exceeds 10^36
+  vector<std::tuple<string, Int, string>> reconstructions = { // integer, exponent, decimal
+    std::make_tuple("123456789012345678901234567890123", 0, "123456789012345678901234567890123"),
+    std::make_tuple("123456789012345678901234567890123", -40, "0.0000000123456789012345678901234567890123"),
+    std::make_tuple("1500", -3, "1.5"),
+    std::make_tuple("1500", -4, "0.15"),
+    std::make_tuple("7", 2, "700"),
+    std::make_tuple("0", -5, "0")
+  };
+  for (const auto &reconstruction : reconstructions) {
+    vector<Int> residues;
+    for (Int modulus : moduli) residues.push_back(getResidue(std::get<0>(reconstruction), modulus));
+    checkEqual(util::reconstructDecimal(residues, moduli, std::get<1>(reconstruction)), std::get<2>(reconstruction), "reconstructDecimal of " + std::get<0>(reconstruction) + "e" + to_string(std::get<1>(reconstruction)));
+  }
+}
+
+void testing::testExactWeightedCounting(const string &dirPath) {
+  VarOrderingHeuristic ddVarOrderingHeuristic = VAR_ORDERING_HEURISTIC_CHOICES.at(DEFAULT_DD_VAR_ORDERING_HEURISTIC_CHOICE);
+  VarOrderingHeuristic cnfVarOrderingHeuristic = VAR_ORDERING_HEURISTIC_CHOICES.at(DEFAULT_CNF_VAR_ORDERING_HEURISTIC_CHOICE);
+
+  string unweightedFilePath = dirPath + "/unweighted.cnf";
+  writeFile(unweightedFilePath, "p cnf 12 8\n1 2 -3 0\n3 4 0\n-4 5 6 0\n-1 -6 7 0\n7 8 -9 0\n9 10 0\n-10 -11 12 0\n-2 11 0\n");
+  Cnf unweightedCnf(unweightedFilePath, WeightFormat::UNWEIGHTED);
+  MonolithicCounter monolithicCounter(ddVarOrderingHeuristic, false);
+  BouquetCounter bouquetTreeCounter(true, cnfVarOrderingHeuristic, false, ddVarOrderingHeuristic, false);
+  string mintermCount = monolithicCounter.getExactModelCount(unweightedCnf);
+  checkEqual(monolithicCounter.getExactWeightedModelCount(unweightedCnf), mintermCount, "modular monolithic count of unweighted cnf");
+  checkEqual(bouquetTreeCounter.getExactWeightedModelCount(unweightedCnf), mintermCount, "modular bouquet tree count of unweighted cnf");
+
+  string weightedFilePath = dirPath + "/weighted.cnf";
+  writeFile(weightedFilePath, "p wcnf 3 2\nw 1 0.3 0\nw -1 0.7 0\nw 2 0.25 0\nw -2 0.75 0\n1 2 0\n-1 3 0\n");
+  Cnf weightedCnf(weightedFilePath, WeightFormat::MCC);
+  checkEqual(bouquetTreeCounter.getExactWeightedModelCount(weightedCnf), "0.65", "modular count of weighted cnf"); // 0.3 * 1 + 0.7 * 0.25 * 2
+}
+
+void testing::testMarginals(const string &dirPath, const Cnf &cnf) {
+  VarOrderingHeuristic ddVarOrderingHeuristic = VAR_ORDERING_HEURISTIC_CHOICES.at(DEFAULT_DD_VAR_ORDERING_HEURISTIC_CHOICE);
+  VarOrderingHeuristic cnfVarOrderingHeuristic = VAR_ORDERING_HEURISTIC_CHOICES.at(DEFAULT_CNF_VAR_ORDERING_HEURISTIC_CHOICE);
+
+  string jtFilePath = dirPath + "/marginals.jt";
+  writeFile(jtFilePath, "p jt 4 2 4\n3 2 e 3\n4 1 3 e 1 2\n"); // outside ADD of node 3 keeps var 1 and sums var 2
+
+  /* count is (w1 w3 (w2 + w-2) + w-1 w2 (w3 + w-3)) (w4 + w-4) = 0.65 * 0.9, with w3 = w-3 = 1 */
+  Map<Int, Float> derivatives = {{1, 0.9}, {-1, 0.45}, {2, 1.53}, {-2, 0.27}, {3, 0.4275}, {-3, 0.1575}, {4, 0.65}, {-4, 0.65}};
+  MonolithicCounter monolithicCounter(ddVarOrderingHeuristic, false);
+  BouquetCounter bouquetTreeCounter(true, cnfVarOrderingHeuristic, false, ddVarOrderingHeuristic, false);
+  JoinTreeCounter joinTreeCounter(jtFilePath, DUMMY_STR, false, DEFAULT_JT_WAIT_SECONDS, 0, 0, 0, ddVarOrderingHeuristic, false);
+  vector<std::pair<string, Counter *>> counters = {{"monolithic counter", &monolithicCounter}, {"bouquet tree counter", &bouquetTreeCounter}, {"jt file", &joinTreeCounter}};
+  for (const auto &counter : counters) {
+    Float modelCount;
+    Map<Int, Float> marginals = counter.second->computeMarginals(cnf, modelCount);
+    checkEqual(to_string(modelCount), to_string(0.585), "count with marginals on join tree from " + counter.first);
+    for (Int literal : {1, -1, 2, -2, 3, -3, 4, -4}) {
+      checkEqual(to_string(marginals.at(literal)), to_string(derivatives.at(literal)), "marginal of literal " + to_string(literal) + " on join tree from " + counter.first);
+    }
+  }
+}
+
+void testing::testCubes(const string &dirPath, const Cnf &cnf) {
+  VarOrderingHeuristic ddVarOrderingHeuristic = VAR_ORDERING_HEURISTIC_CHOICES.at(DEFAULT_DD_VAR_ORDERING_HEURISTIC_CHOICE);
+  VarOrderingHeuristic cnfVarOrderingHeuristic = VAR_ORDERING_HEURISTIC_CHOICES.at(DEFAULT_CNF_VAR_ORDERING_HEURISTIC_CHOICE);
+
+  vector<vector<Int>> cubes = {{}, {1}, {-1, 4}, {4, -1, 4}, {1, -1}, {-4}}; // include repeated literal, contradictory cube, and query var 4 in no clause
+  vector<string> unitCounts; // of cnf with cube as unit clauses
+  for (Int cubeIndex = 0; cubeIndex < cubes.size(); cubeIndex++) {
+    const vector<Int> &cube = cubes.at(cubeIndex);
+    Int varCount = cnf.getDeclaredVarCount();
+    string text = "p wcnf " + to_string(varCount) + " " + to_string(cnf.getClauses().size() + cube.size()) + "\n";
+    for (Int literal = -varCount; literal <= varCount; literal++) {
+      if (literal != 0) text += "w " + to_string(literal) + " " + to_string(cnf.getLiteralWeights().at(literal)) + " 0\n";
+    }
+    for (const vector<Int> &clause : cnf.getClauses()) {
+      for (Int literal : clause) text += to_string(literal) + " ";
+      text += "0\n";
+    }
+    for (Int literal : cube) text += to_string(literal) + " 0\n";
+    string unitFilePath = dirPath + "/cube" + to_string(cubeIndex) + ".cnf";
+    writeFile(unitFilePath, text);
+    MonolithicCounter monolithicCounter(ddVarOrderingHeuristic, false);
+    unitCounts.push_back(to_string(monolithicCounter.getModelCount(Cnf(unitFilePath, WeightFormat::MCC)).toFloat()));
+  }
+
+  queryCnfVars = {1, 4}; // global variable
+  BouquetCounter bouquetTreeCounter(true, cnfVarOrderingHeuristic, false, ddVarOrderingHeuristic, false);
+  bouquetTreeCounter.setJoinTree(cnf);
+  ADD queryDd = bouquetTreeCounter.countJoinTreeDd(cnf);
+  for (Int cubeIndex = 0; cubeIndex < cubes.size(); cubeIndex++) {
+    string cubeString;
+    for (Int literal : cubes.at(cubeIndex)) cubeString += to_string(literal) + " ";
+    checkEqual(to_string(bouquetTreeCounter.countCube(queryDd, cubes.at(cubeIndex), cnf).toFloat()), unitCounts.at(cubeIndex), "count of cube '" + cubeString + "0'"); // free factor of answerQueries is 1 since all vars are queried or projected
+  }
+  queryCnfVars.clear();
+}
+
+int testing::CheckpointInterrupter::overflow(int c) {
+  if (c != '\n') {
+    line += c;
+    return c;
+  }
+  if (line.find("Wrote checkpoint") != string::npos && --remainingCheckpointCount == 0) {
+    raise(SIGTERM); // like 'timeout'; handled by Counter::handleTermination
+  }
+  line.clear();
+  return c;
+}
+
+testing::CheckpointInterrupter::CheckpointInterrupter(Int checkpointCount) : remainingCheckpointCount(checkpointCount) {}
+
+void testing::testCheckpoints(const string &dirPath, const string &cnfFilePath) {
+  VarOrderingHeuristic ddVarOrderingHeuristic = VAR_ORDERING_HEURISTIC_CHOICES.at(DEFAULT_DD_VAR_ORDERING_HEURISTIC_CHOICE);
+  Cnf cnf(cnfFilePath, WeightFormat::UNWEIGHTED);
+  string uninterruptedCount = to_string(LinearCounter(ddVarOrderingHeuristic, false).getModelCount(cnf).toFloat());
+
+  string checkpointDirPath = dirPath + "/checkpoint";
+  Int previousVerbosityLevel = verbosityLevel;
+  checkpointDir = checkpointDirPath; // global variable
+  checkpointSeconds = 0; // checkpoints at every safe point
+  verbosityLevel = 1; // prints 'Wrote checkpoint' comments
+
+  pid_t pid = fork(); // child has own Counter::checkpointRequested, like a separate run
+  if (pid == 0) {
+    CheckpointInterrupter interrupter(3); // linear counter checkpoints before each multiplication
+    cout.rdbuf(&interrupter);
+    bool interrupted = isRejected([&] { LinearCounter(ddVarOrderingHeuristic, false).output(cnfFilePath, WeightFormat::UNWEIGHTED, OutputFormat::MODEL_COUNT); });
+    _exit(interrupted ? 0 : 1);
+  }
+  int status = -1;
+  if (pid > 0) waitpid(pid, &status, 0);
+  checkEqual(WIFEXITED(status) && WEXITSTATUS(status) == 0 ? "interrupted" : "not interrupted", "interrupted", "linear count stopped by SIGTERM");
+  Checkpoint checkpoint;
+  checkEqual(checkpoint.readMetadata(checkpointDirPath) ? to_string(checkpoint.position) : "none", to_string(cnf.getClauses().size() - 1), "checkpoint position after two multiplications"); // position is remaining factor count; factors are constant ADD and clause ADDs
+
+  resumingCheckpoint = true; // global variable
+  std::ostringstream outputStream;
+  std::streambuf *coutBuffer = cout.rdbuf(outputStream.rdbuf());
+  string resumedCount = to_string(LinearCounter(ddVarOrderingHeuristic, false).getModelCount(cnf).toFloat());
+  cout.rdbuf(coutBuffer);
+  checkpointDir = DUMMY_STR;
+  resumingCheckpoint = false;
+  verbosityLevel = previousVerbosityLevel;
+
+  checkEqual(outputStream.str().find("Resuming from checkpoint") != string::npos ? "resumed" : "restarted", "resumed", "linear count after checkpoint");
+  checkEqual(resumedCount, uninterruptedCount, "resumed linear count");
+  checkEqual(Checkpoint().readMetadata(checkpointDirPath) ? "kept" : "removed", "removed", "checkpoint after resumed count finished");
+}
+
+string testing::getSubtreeSignature(JoinNode *joinNode) {
+  if (joinNode->isTerminal()) return to_string(joinNode->getNodeIndex());
+
+  string signature = "(";
+  for (JoinNode *child : joinNode->getChildren()) {
+    signature += getSubtreeSignature(child) + " ";
+  }
+  vector<Int> projectableCnfVars(joinNode->getProjectableCnfVars().begin(), joinNode->getProjectableCnfVars().end());
+  std::sort(projectableCnfVars.begin(), projectableCnfVars.end());
+  signature += "|";
+  for (Int cnfVar : projectableCnfVars) {
+    signature += " " + to_string(cnfVar);
+  }
+  return signature + ")";
+}
+
+void testing::testTreeDecompositions(const string &dirPath, const Cnf &cnf, const CountingSecondsPredictor &predictor) {
+  VarOrderingHeuristic ddVarOrderingHeuristic = VAR_ORDERING_HEURISTIC_CHOICES.at(DEFAULT_DD_VAR_ORDERING_HEURISTIC_CHOICE);
+
+  string tdFilePath = dirPath + "/path.td";
+  writeFile(tdFilePath, "s td 2 3 4\nb 1 1 2 4\nb 2 2 3 4\n1 2\n");
+  JoinTreeReader joinTreeReader(tdFilePath, cnf.getClauses(), DEFAULT_JT_WAIT_SECONDS, 0, 0, predictor, false);
+  checkEqual(getSubtreeSignature(joinTreeReader.getJoinTreeRoot()), "((1 2 | 3) 0 3 | 1 2 4)", "join tree from td"); // clause to covering bag, var to highest bag
+
+  JoinTreeCounter joinTreeCounter(tdFilePath, DUMMY_STR, false, DEFAULT_JT_WAIT_SECONDS, 0, 0, 0, ddVarOrderingHeuristic, false);
+  checkEqual(to_string(joinTreeCounter.getModelCount(cnf).toFloat()), to_string(6.0), "count on join tree from td");
+
+  string repeatedBagFilePath = dirPath + "/repeated_bag.td";
+  writeFile(repeatedBagFilePath, "s td 3 3 4\nb 1 1 2 4\nb 1 1 2 4\nb 2 2 3 4\n1 2\n2 3\n"); // bag 3 is never read
+  bool rejected = isRejected([&] { JoinTreeReader(repeatedBagFilePath, cnf.getClauses(), DEFAULT_JT_WAIT_SECONDS, 0, 0, predictor, false); });
+  checkEqual(rejected ? "rejected" : "accepted", "rejected", "td with repeated bag");
+}
+
+void testing::testBinaryJoinTrees(const string &dirPath, const Cnf &cnf, const CountingSecondsPredictor &predictor) {
+  HashPair cnfHashes = storage::getClauseHashes(cnf);
+
+  string jtFilePath = dirPath + "/text.jt";
+  writeFile(jtFilePath, "p jt 4 4 6\n5 2 3 e 3\n6 1 4 5 e 1 2 4\n");
+  JoinTreeReader textReader(jtFilePath, cnf.getClauses(), DEFAULT_JT_WAIT_SECONDS, 0, 0, predictor, false);
+  string textSignature = getSubtreeSignature(textReader.getJoinTreeRoot());
+  checkEqual(textSignature, "(0 3 (1 2 | 3) | 1 2 4)", "join tree from text jt");
+
+  string jtbFilePath = dirPath + "/binary.jtb";
+  JoinTreeReader::writeBinaryFile(jtbFilePath, textReader.getJoinTreeRoot(), cnf.getDeclaredVarCount(), cnf.getClauses().size(), cnfHashes);
+  JoinTreeReader binaryReader(jtbFilePath, cnf.getClauses(), DEFAULT_JT_WAIT_SECONDS, 0, 0, predictor, false);
+  checkEqual(getSubtreeSignature(binaryReader.getJoinTreeRoot()), textSignature, "binary jt round trip");
+  checkEqual(binaryReader.getBinaryCnfHashes() == cnfHashes ? "same" : "different", "same", "cnf hashes in binary jt");
+
+  std::ifstream inputFileStream(jtbFilePath, std::ios::binary);
+  string bytes((std::istreambuf_iterator<char>(inputFileStream)), std::istreambuf_iterator<char>());
+  int64_t nonterminalCount = std::numeric_limits<int64_t>::max() / 2;
+  std::memcpy(&bytes[offsetof(BinaryJoinTreeHeader, nonterminalCount)], &nonterminalCount, sizeof(nonterminalCount));
+  string corruptFilePath = dirPath + "/corrupt.jtb";
+  writeFile(corruptFilePath, bytes);
+  bool rejected = isRejected([&] { JoinTreeReader(corruptFilePath, cnf.getClauses(), DEFAULT_JT_WAIT_SECONDS, 0, 0, predictor, false); });
+  checkEqual(rejected ? "rejected" : "accepted", "rejected", "binary jt with corrupt node count");
+}
+
+bool testing::runChecks() {
+  verbosityLevel = 0;
+  char dirPathTemplate[] = "/tmp/addmc_test_XXXXXX";
+  if (mkdtemp(dirPathTemplate) == nullptr) {
+    showError("unable to create temp dir for checks");
+  }
+  string dirPath = dirPathTemplate;
+
+  bool passed = !isRejected([&dirPath] {
+    testDecimals();
+    testExactWeightedCounting(dirPath);
+
+    string weightedFilePath = dirPath + "/free_var.cnf";
+    writeFile(weightedFilePath, "p wcnf 4 2\nw 1 0.3 0\nw -1 0.7 0\nw 2 0.25 0\nw -2 0.75 0\nw 4 0.4 0\nw -4 0.5 0\n1 2 0\n-1 3 0\n"); // var 4 is in no clause
+    Cnf weightedCnf(weightedFilePath, WeightFormat::MCC);
+    testMarginals(dirPath, weightedCnf);
+    testCubes(dirPath, weightedCnf);
+
+    string chainFilePath = dirPath + "/chain.cnf";
+    writeFile(chainFilePath, "p cnf 4 4\n1 2 0\n2 3 0\n3 4 0\n-1 4 0\n");
+    Cnf chainCnf(chainFilePath, WeightFormat::UNWEIGHTED);
+    CountingSecondsPredictor predictor = [](JoinNode *) { return 0.0; }; // unused since adaptive waiting is off
+    testTreeDecompositions(dirPath, chainCnf, predictor);
+    testBinaryJoinTrees(dirPath, chainCnf, predictor);
+    testCheckpoints(dirPath, chainFilePath);
+  });
+
+  removeDir(dirPath);
+  if (passed) printComment("All checks passed");
+  return passed;
+}
+
 /* namespace solving **********************************************************/
 
 void solving::solveFile(
   const string &cnfFilePath,
   WeightFormat weightFormat,
   const string &jtFilePath,
+  const string &jtPlannerCommand,
+  bool jtPlannerGraph,
   Float jtWaitSeconds,
+  Float jtMinWaitSeconds,
+  Float jtAdaptiveFactor,
+  Float jtRestartRatio,
   OutputFormat outputFormat,
   ClusteringHeuristic clusteringHeuristic,
   VarOrderingHeuristic cnfVarOrderingHeuristic,
@@ -147,7 +546,12 @@ void solving::solveFile(
     /* optional: */
     util::printRow("weightFormat", util::getWeightFormatName(weightFormat));
     util::printRow("jtFilePath", jtFilePath);
+    util::printRow("jtPlannerCommand", jtPlannerCommand);
+    util::printRow("jtPlannerGraph", jtPlannerGraph);
     util::printRow("jtWaitSeconds", jtWaitSeconds);
+    util::printRow("jtMinWaitSeconds", jtMinWaitSeconds);
+    util::printRow("jtAdaptiveFactor", jtAdaptiveFactor);
+    util::printRow("jtRestartRatio", jtRestartRatio);
     util::printRow("outputFormat", util::getOutputFormatName(outputFormat));
     util::printRow("clustering", util::getClusteringHeuristicName(clusteringHeuristic));
     util::printRow("clusterVarOrder", util::getVarOrderingHeuristicName(cnfVarOrderingHeuristic));
@@ -155,10 +559,30 @@ void solving::solveFile(
     util::printRow("diagramVarOrder", util::getVarOrderingHeuristicName(ddVarOrderingHeuristic));
     util::printRow("inverseDiagramVarOrder", inverseDdVarOrdering);
     util::printRow("randomSeed", randomSeed);
+    util::printRow("subformulaCaching", subformulaCaching);
+    util::printRow("resultCacheDir", resultCacheDir);
+    util::printRow("resultCacheMegabytes", resultCacheMegabytes);
+    util::printRow("resultCachingComponents", resultCachingComponents);
+    util::printRow("checkpointDir", checkpointDir);
+    util::printRow("checkpointSeconds", checkpointSeconds);
+    util::printRow("resumingCheckpoint", resumingCheckpoint);
+    util::printRow("spillDir", spillDir);
+    util::printRow("spillMegabytes", spillMegabytes);
+    util::printRow("binaryJtFilePath", binaryJtFilePath);
+    util::printRow("exactCounting", exactCounting);
+    util::printRow("extendedRange", extendedRange);
+    util::printRow("printingLog10", printingLog10);
+    util::printRow("epsilon", epsilon);
+    util::printRow("computingMarginals", computingMarginals);
+    util::printRow("queryVarCount", queryCnfVars.size());
+    util::printRow("queryFilePath", queryFilePath);
+    util::printRow("semiring", util::getSemiringName(semiring));
+    util::printRow("localDdVars", localDdVars);
+    util::printRow("multiplicationSchedule", util::getMultiplicationScheduleName(multiplicationSchedule));
   }
 
-  if (outputFormat == OutputFormat::MODEL_COUNT && jtFilePath != DUMMY_STR) {
-    JoinTreeCounter joinTreeCounter(jtFilePath, jtWaitSeconds, ddVarOrderingHeuristic, inverseDdVarOrdering);
+  if (jtFilePath != DUMMY_STR || jtPlannerCommand != DUMMY_STR) { // e.g. jt file conversion if outputFormat is JOIN_TREE
+    JoinTreeCounter joinTreeCounter(jtFilePath, jtPlannerCommand, jtPlannerGraph, jtWaitSeconds, jtMinWaitSeconds, jtAdaptiveFactor, jtRestartRatio, ddVarOrderingHeuristic, inverseDdVarOrdering);
     joinTreeCounter.output(cnfFilePath, weightFormat, outputFormat);
     return;
   }
@@ -204,7 +628,12 @@ void solving::solveOptions(
   const string &cnfFilePath,
   Int weightFormatOption,
   const string &jtFilePath,
+  const string &jtPlannerCommand,
+  Int jtPlannerGraphOption,
   Float jtWaitSeconds,
+  Float jtMinWaitSeconds,
+  Float jtAdaptiveFactor,
+  Float jtRestartRatio,
   Int outputFormatOption,
   Int clusteringHeuristicOption,
   Int cnfVarOrderingHeuristicOption,
@@ -258,7 +687,12 @@ void solving::solveOptions(
     cnfFilePath,
     weightFormat,
     jtFilePath,
+    jtPlannerCommand,
+    jtPlannerGraphOption != 0,
     jtWaitSeconds,
+    jtMinWaitSeconds,
+    jtAdaptiveFactor,
+    jtRestartRatio,
     outputFormat,
     clusteringHeuristic,
     cnfVarOrderingHeuristic,
@@ -273,6 +707,36 @@ void solving::solveCommand(int argc, char *argv[]) {
 
   randomSeed = optionDict.randomSeedOption; // global variable
   verbosityLevel = optionDict.verbosityLevelOption; // global variable
+  subformulaCaching = optionDict.subformulaCachingOption != 0; // global variable
+  resultCacheDir = optionDict.resultCacheDirOption; // global variable
+  resultCacheMegabytes = optionDict.resultCacheMegabytesOption; // global variable
+  resultCachingComponents = optionDict.resultCacheComponentsOption != 0; // global variable
+  checkpointDir = optionDict.checkpointDirOption; // global variable
+  checkpointSeconds = optionDict.checkpointSecondsOption; // global variable
+  resumingCheckpoint = optionDict.checkpointResumeOption != 0; // global variable
+  spillDir = optionDict.spillDirOption; // global variable
+  spillMegabytes = optionDict.spillMegabytesOption; // global variable
+  binaryJtFilePath = optionDict.binaryJtFileOption; // global variable
+  exactCounting = optionDict.exactCountingOption != 0; // global variable
+  extendedRange = optionDict.extendedRangeOption != 0; // global variable
+  printingLog10 = optionDict.extendedRangeOption == 2; // global variable
+  epsilon = optionDict.epsilonOption; // global variable
+  computingMarginals = optionDict.marginalsOption != 0; // global variable
+  queryCnfVars = util::getCnfVars(optionDict.queryVarsOption); // global variable
+  queryFilePath = optionDict.queryFileOption; // global variable
+  try {
+    semiring = SEMIRING_CHOICES.at(optionDict.semiringOption); // global variable
+  }
+  catch (const std::out_of_range &) {
+    showError("no such semiringOption: " + to_string(optionDict.semiringOption));
+  }
+  localDdVars = optionDict.localDdVarsOption != 0; // global variable
+  try {
+    multiplicationSchedule = MULTIPLICATION_SCHEDULE_CHOICES.at(optionDict.multiplicationScheduleOption); // global variable
+  }
+  catch (const std::out_of_range &) {
+    showError("no such multiplicationScheduleOption: " + to_string(optionDict.multiplicationScheduleOption));
+  }
   startTime = util::getTimePoint(); // global variable
 
   if (optionDict.helpFlag) {
@@ -286,7 +750,12 @@ void solving::solveCommand(int argc, char *argv[]) {
       optionDict.cnfFilePath,
       optionDict.weightFormatOption,
       optionDict.jtFilePath,
+      optionDict.jtPlannerCommand,
+      optionDict.jtPlannerGraphOption,
       optionDict.jtWaitSeconds,
+      optionDict.jtMinWaitSeconds,
+      optionDict.jtAdaptiveFactor,
+      optionDict.jtRestartRatio,
       optionDict.outputFormatOption,
       optionDict.clusteringHeuristicOption,
       optionDict.cnfVarOrderingHeuristicOption,
@@ -305,5 +774,8 @@ int main(int argc, char *argv[]) {
 
   // mainVisual(argc, argv);
   // testing::test();
+#ifdef TESTING // e.g. 'make test'
+  return testing::runChecks() ? 0 : 1;
+#endif
   solving::solveCommand(argc, argv);
 }
@@ -0,0 +1,339 @@
+/* inclusions *****************************************************************/
+
+#include "../interface/storage.hpp"
+
+/* constants ******************************************************************/
+
+const string &CHECKPOINT_LATEST_FILE_NAME = "latest";
+const string &CHECKPOINT_FILE_PREFIX = "checkpoint";
+const string &CHECKPOINT_METADATA_EXTENSION = ".txt";
+const string &CHECKPOINT_DDS_EXTENSION = ".dds";
+const Int CHECKPOINT_VERSION = 1; // increment when metadata or ADD format changes
+
+const Int SPILL_MIN_NODE_COUNT = 1 << 8;
+const string &SPILL_FILE_EXTENSION = ".dds";
+
+/* namespaces *****************************************************************/
+
+/* namespace storage **********************************************************/
+
+HashPair storage::getClauseHashes(const Cnf &cnf) {
+  Hasher hasher;
+  hasher.mix(cnf.getDeclaredVarCount());
+  hasher.mix(cnf.getClauses().size());
+  for (const vector<Int> &clause : cnf.getClauses()) {
+    hasher.mix(clause.size());
+    for (Int literal : clause) hasher.mix(literal);
+  }
+  return hasher.getHashes();
+}
+
+void storage::writeDds(std::ostream &outputStream, const vector<ADD> &dds) {
+  Map<DdNode *, Int> nodeIds;
+  vector<DdNode *> nodes; // children before parents
+  for (const ADD &dd : dds) {
+    vector<std::pair<DdNode *, bool>> stack = {{dd.getNode(), false}}; // (node, children pushed)
+    while (!stack.empty()) {
+      DdNode *node = stack.back().first;
+      bool childrenPushed = stack.back().second;
+      stack.pop_back();
+      if (nodeIds.find(node) != nodeIds.end()) continue;
+      if (Cudd_IsConstant(node) || childrenPushed) {
+        nodeIds[node] = nodes.size();
+        nodes.push_back(node);
+      }
+      else {
+        stack.push_back({node, true});
+        stack.push_back({cuddE(node), false});
+        stack.push_back({cuddT(node), false});
+      }
+    }
+  }
+
+  outputStream << nodes.size() << " " << dds.size() << "\n" << std::hexfloat; // exact terminals
+  for (DdNode *node : nodes) {
+    if (Cudd_IsConstant(node)) {
+      outputStream << "c " << cuddV(node) << "\n";
+    }
+    else {
+      outputStream << "n " << Cudd_NodeReadIndex(node) << " " << nodeIds.at(cuddT(node)) << " " << nodeIds.at(cuddE(node)) << "\n";
+    }
+  }
+  for (const ADD &dd : dds) {
+    outputStream << nodeIds.at(dd.getNode()) << "\n";
+  }
+  outputStream << std::defaultfloat;
+}
+
+vector<ADD> storage::readDds(std::istream &inputStream, const Cudd &mgr) {
+  Int nodeCount, ddCount;
+  if (!(inputStream >> nodeCount >> ddCount)) {
+    showError("malformed ADD stream header");
+  }
+
+  vector<ADD> nodeDds;
+  for (Int nodeId = 0; nodeId < nodeCount; nodeId++) {
+    string kind;
+    inputStream >> kind;
+    if (kind == "c") {
+      string value; // `>>` does not parse hexadecimal floats
+      inputStream >> value;
+      nodeDds.push_back(mgr.constant(std::strtod(value.c_str(), nullptr)));
+    }
+    else if (kind == "n") {
+      Int ddVar, thenId, elseId;
+      inputStream >> ddVar >> thenId >> elseId;
+      if (thenId >= nodeId || elseId >= nodeId) {
+        showError("ADD node " + to_string(nodeId) + " has forward child");
+      }
+      nodeDds.push_back(mgr.addVar(ddVar).Ite(nodeDds.at(thenId), nodeDds.at(elseId))); // valid under any current ddVar order
+    }
+    else {
+      showError("malformed ADD node " + to_string(nodeId));
+    }
+  }
+
+  vector<ADD> dds;
+  for (Int ddIndex = 0; ddIndex < ddCount; ddIndex++) {
+    Int nodeId;
+    if (!(inputStream >> nodeId) || nodeId < 0 || nodeId >= nodeCount) {
+      showError("malformed ADD root " + to_string(ddIndex));
+    }
+    dds.push_back(nodeDds.at(nodeId));
+  }
+  return dds;
+}
+
+bool storage::writeDdsFile(const string &filePath, const vector<ADD> &dds) {
+  string tempPath = filePath + ".tmp" + to_string(getpid());
+  {
+    std::ofstream tempStream(tempPath);
+    if (!tempStream.is_open()) return false;
+    writeDds(tempStream, dds);
+    if (!tempStream.flush()) {
+      unlink(tempPath.c_str());
+      return false;
+    }
+  }
+  if (rename(tempPath.c_str(), filePath.c_str()) != 0) {
+    unlink(tempPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+vector<ADD> storage::readDdsFile(const string &filePath, const Cudd &mgr) {
+  std::ifstream inputStream(filePath);
+  if (!inputStream.is_open()) {
+    showError("unable to open ADD file '" + filePath + "'");
+  }
+  return readDds(inputStream, mgr);
+}
+
+/* classes ********************************************************************/
+
+/* class Checkpoint ***********************************************************/
+
+Int Checkpoint::readLatestGeneration(const string &dirPath) {
+  std::ifstream latestStream(dirPath + "/" + CHECKPOINT_LATEST_FILE_NAME);
+  Int latestGeneration;
+  if (latestStream >> latestGeneration) return latestGeneration;
+  return DUMMY_MIN_INT;
+}
+
+string Checkpoint::getFilePathPrefix(const string &dirPath, Int generation) {
+  return dirPath + "/" + CHECKPOINT_FILE_PREFIX + to_string(generation);
+}
+
+void Checkpoint::write(const string &dirPath) {
+  if (mkdir(dirPath.c_str(), 0755) != 0 && errno != EEXIST) {
+    showWarning("unable to create checkpoint directory '" + dirPath + "'");
+    return;
+  }
+
+  Int previousGeneration = readLatestGeneration(dirPath);
+  generation = std::max(previousGeneration, (Int)0) + 1;
+  string prefix = getFilePathPrefix(dirPath, generation);
+
+  if (!storage::writeDdsFile(prefix + CHECKPOINT_DDS_EXTENSION, dds)) {
+    showWarning("unable to write checkpoint ADDs '" + prefix + CHECKPOINT_DDS_EXTENSION + "'");
+    return;
+  }
+  {
+    std::ofstream metadataStream(prefix + CHECKPOINT_METADATA_EXTENSION);
+    metadataStream << "version " << CHECKPOINT_VERSION << "\n";
+    metadataStream << "algorithm " << algorithm << "\n";
+    metadataStream << "cnfHashes " << cnfHashes.first << " " << cnfHashes.second << "\n";
+    metadataStream << "position " << position << "\n";
+    metadataStream << "ddExponent " << ddExponent << "\n";
+    metadataStream << "roundingCount " << roundingCount << "\n";
+    for (const auto &field : vector<std::pair<string, const vector<Int> *>>{
+      {"ddVarOrdering", &ddVarOrdering},
+      {"ddVarLevels", &ddVarLevels},
+      {"cnfVarOrdering", &cnfVarOrdering},
+      {"projectedCnfVars", &projectedCnfVars},
+      {"ddTags", &ddTags},
+      {"ddPositions", &ddPositions}
+    }) {
+      metadataStream << field.first;
+      for (Int i : *field.second) metadataStream << " " << i;
+      metadataStream << "\n";
+    }
+    if (!metadataStream.flush()) {
+      showWarning("unable to write checkpoint metadata '" + prefix + CHECKPOINT_METADATA_EXTENSION + "'");
+      return;
+    }
+  }
+
+  string latestPath = dirPath + "/" + CHECKPOINT_LATEST_FILE_NAME;
+  string tempPath = latestPath + ".tmp" + to_string(getpid());
+  {
+    std::ofstream tempStream(tempPath);
+    tempStream << generation << "\n";
+  }
+  if (rename(tempPath.c_str(), latestPath.c_str()) != 0) { // switches to new checkpoint atomically
+    unlink(tempPath.c_str());
+    showWarning("unable to rename checkpoint pointer '" + tempPath + "'");
+    return;
+  }
+
+  if (previousGeneration != DUMMY_MIN_INT) {
+    string previousPrefix = getFilePathPrefix(dirPath, previousGeneration);
+    unlink((previousPrefix + CHECKPOINT_DDS_EXTENSION).c_str());
+    unlink((previousPrefix + CHECKPOINT_METADATA_EXTENSION).c_str());
+  }
+}
+
+bool Checkpoint::readMetadata(const string &dirPath) {
+  generation = readLatestGeneration(dirPath);
+  if (generation == DUMMY_MIN_INT) return false;
+
+  string metadataPath = getFilePathPrefix(dirPath, generation) + CHECKPOINT_METADATA_EXTENSION;
+  std::ifstream metadataStream(metadataPath);
+  if (!metadataStream.is_open()) {
+    showError("unable to open checkpoint metadata '" + metadataPath + "'");
+  }
+
+  Map<string, vector<Int> *> intFields = {
+    {"ddVarOrdering", &ddVarOrdering},
+    {"ddVarLevels", &ddVarLevels},
+    {"cnfVarOrdering", &cnfVarOrdering},
+    {"projectedCnfVars", &projectedCnfVars},
+    {"ddTags", &ddTags},
+    {"ddPositions", &ddPositions}
+  };
+  Int version = DUMMY_MIN_INT;
+  string line;
+  while (std::getline(metadataStream, line)) {
+    std::istringstream lineStream(line);
+    string key;
+    lineStream >> key;
+    if (key == "version") lineStream >> version;
+    else if (key == "algorithm") {
+      std::getline(lineStream >> std::ws, algorithm);
+    }
+    else if (key == "cnfHashes") lineStream >> cnfHashes.first >> cnfHashes.second;
+    else if (key == "position") lineStream >> position;
+    else if (key == "ddExponent") lineStream >> ddExponent;
+    else if (key == "roundingCount") lineStream >> roundingCount;
+    else if (intFields.find(key) != intFields.end()) {
+      vector<Int> &ints = *intFields.at(key);
+      Int i;
+      while (lineStream >> i) ints.push_back(i);
+    }
+  }
+  if (version != CHECKPOINT_VERSION) {
+    showError("checkpoint '" + metadataPath + "' has version " + to_string(version) + " instead of " + to_string(CHECKPOINT_VERSION));
+  }
+  return true;
+}
+
+void Checkpoint::readDds(const string &dirPath, const Cudd &mgr) {
+  dds = storage::readDdsFile(getFilePathPrefix(dirPath, generation) + CHECKPOINT_DDS_EXTENSION, mgr);
+  if (dds.size() != ddTags.size() || dds.size() != ddPositions.size()) {
+    showError("checkpoint has " + to_string(dds.size()) + " ADDs but " + to_string(ddTags.size()) + " tags");
+  }
+}
+
+void Checkpoint::remove(const string &dirPath) {
+  Int latestGeneration = readLatestGeneration(dirPath);
+  if (latestGeneration == DUMMY_MIN_INT) return;
+  string prefix = getFilePathPrefix(dirPath, latestGeneration);
+  unlink((dirPath + "/" + CHECKPOINT_LATEST_FILE_NAME).c_str());
+  unlink((prefix + CHECKPOINT_DDS_EXTENSION).c_str());
+  unlink((prefix + CHECKPOINT_METADATA_EXTENSION).c_str());
+}
+
+/* class SpillManager *********************************************************/
+
+string SpillManager::getFilePath(Int spillId) const {
+  return dirPath + "/" + to_string(spillId) + SPILL_FILE_EXTENSION;
+}
+
+bool SpillManager::isUsable() const {
+  return usable;
+}
+
+bool SpillManager::isUnderPressure(const Cudd &mgr) const {
+  return usable && mgr.ReadNodeCount() > maxNodeCount; // dead nodes are excluded
+}
+
+bool SpillManager::isWorthSpilling(const ADD &dd) const {
+  return dd.nodeCount() >= SPILL_MIN_NODE_COUNT;
+}
+
+Int SpillManager::spill(const ADD &dd) {
+  if (!usable) return DUMMY_MIN_INT;
+
+  if (spillCount == 0) {
+    mkdir(dirPath.substr(0, dirPath.rfind('/')).c_str(), 0755);
+  }
+  if (spillCount == 0 && mkdir(dirPath.c_str(), 0700) != 0 && errno != EEXIST) {
+    showWarning("unable to create spill directory '" + dirPath + "'; not spilling");
+    usable = false;
+    return DUMMY_MIN_INT;
+  }
+
+  Int spillId = nextSpillId++;
+  if (!storage::writeDdsFile(getFilePath(spillId), {dd})) {
+    showWarning("unable to write spill file '" + getFilePath(spillId) + "'; not spilling");
+    usable = false;
+    return DUMMY_MIN_INT;
+  }
+  spillCount++;
+  return spillId;
+}
+
+ADD SpillManager::reload(Int spillId, const Cudd &mgr) {
+  ADD dd = peek(spillId, mgr);
+  unlink(getFilePath(spillId).c_str());
+  reloadCount++;
+  return dd;
+}
+
+ADD SpillManager::peek(Int spillId, const Cudd &mgr) const {
+  return util::getSoleMember(storage::readDdsFile(getFilePath(spillId), mgr));
+}
+
+void SpillManager::removeFiles() {
+  if (spillCount > 0) {
+    for (Int spillId = 0; spillId < nextSpillId; spillId++) {
+      unlink(getFilePath(spillId).c_str());
+    }
+    rmdir(dirPath.c_str());
+  }
+  usable = false;
+}
+
+void SpillManager::printStats() const {
+  util::printRow("spilledAddCount", spillCount);
+  util::printRow("reloadedAddCount", reloadCount);
+}
+
+SpillManager::SpillManager() {}
+
+SpillManager::SpillManager(const string &parentDirPath, Float maxMegabytes) {
+  dirPath = parentDirPath + "/addmc" + to_string(getpid()); // concurrent processes may share parentDirPath
+  maxNodeCount = maxMegabytes * (1 << 20) / sizeof(DdNode);
+  usable = true;
+}
@@ -7,6 +7,27 @@
 Int randomSeed = DEFAULT_RANDOM_SEED;
 Int verbosityLevel = DEFAULT_VERBOSITY_LEVEL_CHOICE;
 TimePoint startTime;
+bool subformulaCaching = false;
+string resultCacheDir;
+Float resultCacheMegabytes;
+bool resultCachingComponents = false;
+string checkpointDir;
+Float checkpointSeconds;
+bool resumingCheckpoint = false;
+string spillDir;
+Float spillMegabytes;
+string binaryJtFilePath;
+bool exactCounting = false;
+bool extendedRange = false;
+bool printingLog10 = false;
+Float epsilon = 0;
+bool computingMarginals = false;
+Set<Int> queryCnfVars;
+string queryFilePath;
+Semiring semiring = Semiring::SUM_PRODUCT;
+Int terminalModulus = DUMMY_MIN_INT;
+MultiplicationSchedule multiplicationSchedule = MultiplicationSchedule::LEFT_TO_RIGHT;
+bool localDdVars = false;
 
 /* constants ******************************************************************/
 
@@ -22,13 +43,37 @@ const string &HELP_OPTION = "h, hi";
 const string &CNF_FILE_OPTION = "cf";
 const string &WEIGHT_FORMAT_OPTION = "wf";
 const string &JT_FILE_OPTION = "jf";
+const string &JT_PLANNER_OPTION = "jp";
+const string &JT_PLANNER_GRAPH_OPTION = "jg";
 const string &JT_WAIT_DURAION_OPTION = "jw";
+const string &JT_MIN_WAIT_OPTION = "jm";
+const string &JT_ADAPTIVE_WAIT_OPTION = "ja";
+const string &JT_RESTART_RATIO_OPTION = "jr";
+const string &JT_BINARY_OUTPUT_OPTION = "jo";
 const string &OUTPUT_FORMAT_OPTION = "of";
 const string &CLUSTERING_HEURISTIC_OPTION = "ch";
 const string &CLUSTER_VAR_ORDER_OPTION = "cv";
 const string &DIAGRAM_VAR_ORDER_OPTION = "dv";
 const string &RANDOM_SEED_OPTION = "rs";
 const string &VERBOSITY_LEVEL_OPTION = "vl";
+const string &SUBFORMULA_CACHING_OPTION = "sc";
+const string &RESULT_CACHE_DIR_OPTION = "rc";
+const string &RESULT_CACHE_MEGABYTES_OPTION = "rm";
+const string &RESULT_CACHE_COMPONENTS_OPTION = "rp";
+const string &CHECKPOINT_DIR_OPTION = "cd";
+const string &CHECKPOINT_SECONDS_OPTION = "ci";
+const string &CHECKPOINT_RESUME_OPTION = "cr";
+const string &SPILL_DIR_OPTION = "sd";
+const string &SPILL_MEGABYTES_OPTION = "sm";
+const string &EXACT_COUNTING_OPTION = "ex";
+const string &EXTENDED_RANGE_OPTION = "er";
+const string &EPSILON_OPTION = "ep";
+const string &MARGINALS_OPTION = "mg";
+const string &QUERY_VARS_OPTION = "qv";
+const string &QUERY_FILE_OPTION = "qf";
+const string &SEMIRING_OPTION = "sr";
+const string &LOCAL_DD_VARS_OPTION = "lv";
+const string &MULTIPLICATION_SCHEDULE_OPTION = "ms";
 
 const std::map<Int, WeightFormat> WEIGHT_FORMAT_CHOICES = {
   {1, WeightFormat::UNWEIGHTED},
@@ -38,7 +83,11 @@ const std::map<Int, WeightFormat> WEIGHT_FORMAT_CHOICES = {
 };
 const Int DEFAULT_WEIGHT_FORMAT_CHOICE = 4;
 
+const Int DEFAULT_JT_PLANNER_GRAPH_CHOICE = 0;
 const Float DEFAULT_JT_WAIT_SECONDS = 10.0;
+const Float DEFAULT_JT_MIN_WAIT_SECONDS = 0.0;
+const Float DEFAULT_JT_ADAPTIVE_FACTOR = 0.0;
+const Float DEFAULT_JT_RESTART_RATIO = 0.0;
 
 const std::map<Int, OutputFormat> OUTPUT_FORMAT_CHOICES = {
   {1, OutputFormat::JOIN_TREE},
@@ -72,6 +121,42 @@ const Int DEFAULT_RANDOM_SEED = 10;
 const vector<Int> VERBOSITY_LEVEL_CHOICES = {0, 1, 2, 3, 4};
 const Int DEFAULT_VERBOSITY_LEVEL_CHOICE = 0;
 
+const Int DEFAULT_SUBFORMULA_CACHING_CHOICE = 0;
+
+const Float DEFAULT_RESULT_CACHE_MEGABYTES = 64.0;
+const Int DEFAULT_RESULT_CACHE_COMPONENTS_CHOICE = 0;
+
+const Float DEFAULT_CHECKPOINT_SECONDS = 600;
+const Int DEFAULT_CHECKPOINT_RESUME_CHOICE = 0;
+
+const Float DEFAULT_SPILL_MEGABYTES = 4096.0;
+
+const Int DEFAULT_EXACT_COUNTING_CHOICE = 0;
+
+const Int DEFAULT_EXTENDED_RANGE_CHOICE = 0;
+
+const Float DEFAULT_EPSILON = 0;
+
+const Int DEFAULT_MARGINALS_CHOICE = 0;
+
+const std::map<Int, Semiring> SEMIRING_CHOICES = {
+  {1, Semiring::SUM_PRODUCT},
+  {2, Semiring::MAX_PRODUCT},
+  {3, Semiring::LOG_SUM_EXP}
+};
+const Int DEFAULT_SEMIRING_CHOICE = 1;
+
+const Int DEFAULT_LOCAL_DD_VARS_CHOICE = 0;
+
+const std::map<Int, MultiplicationSchedule> MULTIPLICATION_SCHEDULE_CHOICES = {
+  {1, MultiplicationSchedule::LEFT_TO_RIGHT},
+  {2, MultiplicationSchedule::SMALLEST_FIRST},
+  {3, MultiplicationSchedule::MAX_OVERLAP}
+};
+const Int DEFAULT_MULTIPLICATION_SCHEDULE_CHOICE = 1;
+
+const Int MAX_MODULUS = Int(1) << 31;
+
 const Float NEGATIVE_INFINITY = -std::numeric_limits<Float>::infinity();
 
 const Int DUMMY_MIN_INT = std::numeric_limits<Int>::min();
@@ -81,6 +166,54 @@ const string &DUMMY_STR = "";
 
 const string &DOT_DIR = "./";
 
+/* types **********************************************************************/
+
+/* class ExtendedFloat ********************************************************/
+
+Float ExtendedFloat::toFloat() const {
+  Int clampedExponent = std::max(std::min(exponent, (Int)100000), (Int)-100000); // ldexp takes int
+  return std::ldexp(mantissa, clampedExponent);
+}
+
+Float ExtendedFloat::getLog10() const {
+  return std::log10(std::abs(mantissa)) + exponent * std::log10(2.0);
+}
+
+string ExtendedFloat::toScientificString() const {
+  std::ostringstream stream;
+  if (mantissa == 0 || !std::isfinite(mantissa)) {
+    stream << mantissa;
+    return stream.str();
+  }
+
+  Float log10Value = getLog10();
+  Int decimalExponent = std::floor(log10Value);
+  Float decimalMantissa = std::pow(10.0, log10Value - decimalExponent);
+  if (decimalMantissa >= 9.999995) { // would print as 10
+    decimalMantissa /= 10;
+    decimalExponent++;
+  }
+  stream << (mantissa < 0 ? "-" : "") << decimalMantissa << "e" << (decimalExponent < 0 ? "-" : "+") << std::setw(2) << std::setfill('0') << std::abs(decimalExponent);
+  return stream.str();
+}
+
+ExtendedFloat ExtendedFloat::operator*(const ExtendedFloat &other) const {
+  return ExtendedFloat(mantissa * other.mantissa, exponent + other.exponent);
+}
+
+ExtendedFloat &ExtendedFloat::operator*=(const ExtendedFloat &other) {
+  *this = *this * other;
+  return *this;
+}
+
+ExtendedFloat::ExtendedFloat(Float f) : ExtendedFloat(f, 0) {}
+
+ExtendedFloat::ExtendedFloat(Float mantissa, Int exponent) {
+  int shift = 0;
+  this->mantissa = std::frexp(mantissa, &shift);
+  this->exponent = mantissa == 0 || !std::isfinite(mantissa) ? 0 : exponent + shift;
+}
+
 /* namespaces *****************************************************************/
 
 /* namespace util *************************************************************/
@@ -99,7 +232,22 @@ void util::printComment(const string &message, Int preceedingNewLines, Int follo
   for (Int i = 0; i < followingNewLines; i++) cout << "\n";
 }
 
-void util::printSolutionLine(WeightFormat weightFormat, Float modelCount, Int preceedingThinLines, Int followingThinLines) {
+string util::getModelCountString(const ExtendedFloat &modelCount) {
+  if (extendedRange && !printingLog10) return modelCount.toScientificString();
+
+  std::ostringstream outputStream;
+  outputStream << (extendedRange ? modelCount.getLog10() : modelCount.toFloat());
+  return outputStream.str();
+}
+
+void util::printSolutionLine(WeightFormat weightFormat, const ExtendedFloat &modelCount, Int preceedingThinLines, Int followingThinLines) {
+  for (Int i = 0; i < preceedingThinLines; i++) printThinLine();
+  cout << "s " << (extendedRange && printingLog10 ? "log10-" : "") << (semiring == Semiring::MAX_PRODUCT ? "mpe" : weightFormat == WeightFormat::UNWEIGHTED ? "mc" : "wmc") << " ";
+  cout << getModelCountString(modelCount) << "\n";
+  for (Int i = 0; i < followingThinLines; i++) printThinLine();
+}
+
+void util::printSolutionLine(WeightFormat weightFormat, const string &modelCount, Int preceedingThinLines, Int followingThinLines) {
   for (Int i = 0; i < preceedingThinLines; i++) printThinLine();
   cout << "s " << (weightFormat == WeightFormat::UNWEIGHTED ? "mc" : "wmc") << " " << modelCount << "\n";
   for (Int i = 0; i < followingThinLines; i++) printThinLine();
@@ -142,11 +290,41 @@ void util::printJtFileOption() {
   cout << "Default: (no jt file)\n";
 }
 
+void util::printJtPlannerOption() {
+  cout << "      --" << JT_PLANNER_OPTION << std::left << std::setw(56) << " arg  jt planner command (spawned with cnf on its stdin)";
+  cout << "Default: (no planner)\n";
+}
+
+void util::printJtPlannerGraphOption() {
+  cout << "      --" << JT_PLANNER_GRAPH_OPTION << std::left << std::setw(56) << " arg  jt planner reads primal graph (PACE gr): 0, 1";
+  cout << "Default: " + to_string(DEFAULT_JT_PLANNER_GRAPH_CHOICE) + "\n";
+}
+
 void util::printJtWaitOption() {
-  cout << "      --" << JT_WAIT_DURAION_OPTION << std::left << std::setw(56) << " arg  jt wait duration before tree builder is killed";
+  cout << "      --" << JT_WAIT_DURAION_OPTION << std::left << std::setw(56) << " arg  jt wait upper bound before planner is killed";
   cout << "Default: " + to_string(DEFAULT_JT_WAIT_SECONDS) + " (seconds)\n";
 }
 
+void util::printJtMinWaitOption() {
+  cout << "      --" << JT_MIN_WAIT_OPTION << std::left << std::setw(56) << " arg  jt wait lower bound if adaptive";
+  cout << "Default: " + to_string(DEFAULT_JT_MIN_WAIT_SECONDS) + " (seconds)\n";
+}
+
+void util::printJtAdaptiveWaitOption() {
+  cout << "      --" << JT_ADAPTIVE_WAIT_OPTION << std::left << std::setw(56) << " arg  stop planning at this times predicted count time";
+  cout << "Default: " + to_string(DEFAULT_JT_ADAPTIVE_FACTOR) + " (0: wait upper bound)\n";
+}
+
+void util::printJtBinaryOutputOption() {
+  cout << "      --" << JT_BINARY_OUTPUT_OPTION << std::left << std::setw(56) << " arg  binary jt file written instead of printing jt";
+  cout << "Default: (printing jt)\n";
+}
+
+void util::printJtRestartOption() {
+  cout << "      --" << JT_RESTART_RATIO_OPTION << std::left << std::setw(56) << " arg  restart count on jt this many times cheaper (0: off)";
+  cout << "Default: " + to_string(DEFAULT_JT_RESTART_RATIO) + "\n";
+}
+
 void util::printOutputFormatOption() {
   cout << "      --" << OUTPUT_FORMAT_OPTION << " arg  ";
   cout << "output format:\n";
@@ -209,6 +387,108 @@ void util::printVerbosityLevelOption() {
   }
 }
 
+void util::printSubformulaCachingOption() {
+  cout << "      --" << SUBFORMULA_CACHING_OPTION << std::left << std::setw(56) << " arg  subformula caching (up to var renaming): 0, 1";
+  cout << "Default: " + to_string(DEFAULT_SUBFORMULA_CACHING_CHOICE) + "\n";
+}
+
+void util::printResultCacheDirOption() {
+  cout << "      --" << RESULT_CACHE_DIR_OPTION << std::left << std::setw(56) << " arg  result cache dir (shared by addmc processes)";
+  cout << "Default: (no result cache)\n";
+}
+
+void util::printResultCacheMegabytesOption() {
+  cout << "      --" << RESULT_CACHE_MEGABYTES_OPTION << std::left << std::setw(56) << " arg  result cache size before LRU eviction";
+  cout << "Default: " + to_string(DEFAULT_RESULT_CACHE_MEGABYTES) + " (megabytes)\n";
+}
+
+void util::printResultCacheComponentsOption() {
+  cout << "      --" << RESULT_CACHE_COMPONENTS_OPTION << std::left << std::setw(56) << " arg  result caching per connected component: 0, 1";
+  cout << "Default: " + to_string(DEFAULT_RESULT_CACHE_COMPONENTS_CHOICE) + "\n";
+}
+
+void util::printCheckpointDirOption() {
+  cout << "      --" << CHECKPOINT_DIR_OPTION << std::left << std::setw(56) << " arg  checkpoint dir (SIGTERM writes final checkpoint)";
+  cout << "Default: (no checkpointing)\n";
+}
+
+void util::printCheckpointSecondsOption() {
+  cout << "      --" << CHECKPOINT_SECONDS_OPTION << std::left << std::setw(56) << " arg  checkpoint interval";
+  cout << "Default: " + to_string(DEFAULT_CHECKPOINT_SECONDS) + " (seconds)\n";
+}
+
+void util::printCheckpointResumeOption() {
+  cout << "      --" << CHECKPOINT_RESUME_OPTION << std::left << std::setw(56) << " arg  resume from latest checkpoint: 0, 1";
+  cout << "Default: " + to_string(DEFAULT_CHECKPOINT_RESUME_CHOICE) + "\n";
+}
+
+void util::printSpillDirOption() {
+  cout << "      --" << SPILL_DIR_OPTION << std::left << std::setw(56) << " arg  spill dir for idle ADDs (local disk)";
+  cout << "Default: (no spilling)\n";
+}
+
+void util::printSpillMegabytesOption() {
+  cout << "      --" << SPILL_MEGABYTES_OPTION << std::left << std::setw(56) << " arg  ADD node memory before spilling";
+  cout << "Default: " + to_string(DEFAULT_SPILL_MEGABYTES) + " (megabytes)\n";
+}
+
+void util::printExtendedRangeOption() {
+  cout << "      --" << EXTENDED_RANGE_OPTION << std::left << std::setw(56) << " arg  extended range: 0 off, 1 scientific, 2 log10";
+  cout << "Default: " + to_string(DEFAULT_EXTENDED_RANGE_CHOICE) + "\n";
+}
+
+void util::printEpsilonOption() {
+  cout << "      --" << EPSILON_OPTION << std::left << std::setw(56) << " arg  relative tolerance for merging ADD terminals";
+  cout << "Default: " + to_string(DEFAULT_EPSILON) + " (exact)\n";
+}
+
+void util::printMarginalsOption() {
+  cout << "      --" << MARGINALS_OPTION << std::left << std::setw(56) << " arg  marginals of all literals: 0, 1";
+  cout << "Default: " + to_string(DEFAULT_MARGINALS_CHOICE) + "\n";
+}
+
+void util::printQueryVarsOption() {
+  cout << "      --" << QUERY_VARS_OPTION << std::left << std::setw(56) << " arg  query vars kept in final ADD, e.g. '1,5,9'";
+  cout << "Default: (no querying)\n";
+}
+
+void util::printQueryFileOption() {
+  cout << "      --" << QUERY_FILE_OPTION << std::left << std::setw(56) << " arg  query cubes, one per line, e.g. '1 -5 0'";
+  cout << "Default: -\n";
+}
+
+void util::printSemiringOption() {
+  cout << "      --" << SEMIRING_OPTION << " arg  ";
+  cout << "semiring of ADD operations:\n";
+  for (const auto &kv : SEMIRING_CHOICES) {
+    int num = kv.first;
+    cout << "           " << num << "    " << std::left << std::setw(50) << getSemiringName(kv.second);
+    if (num == DEFAULT_SEMIRING_CHOICE) cout << "Default: " << DEFAULT_SEMIRING_CHOICE;
+    cout << "\n";
+  }
+}
+
+void util::printLocalDdVarsOption() {
+  cout << "      --" << LOCAL_DD_VARS_OPTION << std::left << std::setw(56) << " arg  recycled ADD vars in join tree counting: 0, 1";
+  cout << "Default: " + to_string(DEFAULT_LOCAL_DD_VARS_CHOICE) + "\n";
+}
+
+void util::printMultiplicationScheduleOption() {
+  cout << "      --" << MULTIPLICATION_SCHEDULE_OPTION << " arg  ";
+  cout << "multiplication schedule of ADD operands:\n";
+  for (const auto &kv : MULTIPLICATION_SCHEDULE_CHOICES) {
+    int num = kv.first;
+    cout << "           " << num << "    " << std::left << std::setw(50) << getMultiplicationScheduleName(kv.second);
+    if (num == DEFAULT_MULTIPLICATION_SCHEDULE_CHOICE) cout << "Default: " << DEFAULT_MULTIPLICATION_SCHEDULE_CHOICE;
+    cout << "\n";
+  }
+}
+
+void util::printExactCountingOption() {
+  cout << "      --" << EXACT_COUNTING_OPTION << std::left << std::setw(56) << " arg  exact count (weighted via CRT of residues): 0, 1";
+  cout << "Default: " + to_string(DEFAULT_EXACT_COUNTING_CHOICE) + "\n";
+}
+
 /* functions: argument parsing ************************************************/
 
 vector<string> util::getArgV(int argc, char *argv[]) {
@@ -217,6 +497,20 @@ vector<string> util::getArgV(int argc, char *argv[]) {
   return argV;
 }
 
+Set<Int> util::getCnfVars(const string &cnfVarsString) {
+  Set<Int> cnfVars;
+  if (cnfVarsString == DUMMY_STR) return cnfVars;
+
+  std::istringstream inputStream(cnfVarsString);
+  string word;
+  while (std::getline(inputStream, word, ',')) {
+    Int cnfVar = std::stoll(word);
+    if (cnfVar <= 0) showError("cnf var " + word + " is not positive");
+    cnfVars.insert(cnfVar);
+  }
+  return cnfVars;
+}
+
 string util::getWeightFormatName(WeightFormat weightFormat) {
   switch (weightFormat) {
     case WeightFormat::UNWEIGHTED: {
@@ -331,6 +625,45 @@ string util::getVerbosityLevelName(Int verbosityLevel) {
   }
 }
 
+string util::getSemiringName(Semiring semiring) {
+  switch (semiring) {
+    case Semiring::SUM_PRODUCT: {
+      return "SUM_PRODUCT (weighted count)";
+    }
+    case Semiring::MAX_PRODUCT: {
+      return "MAX_PRODUCT (max weight of a model)";
+    }
+    case Semiring::LOG_SUM_EXP: {
+      return "LOG_SUM_EXP (weighted count via log terminals)";
+    }
+    case Semiring::MODULAR_SUM_PRODUCT: {
+      return "MODULAR_SUM_PRODUCT (residue of integer-weighted count)";
+    }
+    default: {
+      showError("no such semiring");
+      return DUMMY_STR;
+    }
+  }
+}
+
+string util::getMultiplicationScheduleName(MultiplicationSchedule multiplicationSchedule) {
+  switch (multiplicationSchedule) {
+    case MultiplicationSchedule::LEFT_TO_RIGHT: {
+      return "LEFT_TO_RIGHT (each ADD once ready)";
+    }
+    case MultiplicationSchedule::SMALLEST_FIRST: {
+      return "SMALLEST_FIRST (two ADDs with fewest nodes)";
+    }
+    case MultiplicationSchedule::MAX_OVERLAP: {
+      return "MAX_OVERLAP (smallest ADD and most shared vars)";
+    }
+    default: {
+      showError("no such multiplicationSchedule");
+      return DUMMY_STR;
+    }
+  }
+}
+
 /* functions: CNF *************************************************************/
 
 Int util::getCnfVar(Int literal) {
@@ -426,6 +759,158 @@ void util::printLiteralWeights(const Map<Int, Float> &literalWeights) {
   printThinLine();
 }
 
+/* functions: exact arithmetic ***********************************************/
+
+bool util::parseDecimal(Decimal &decimal, const string &word) {
+  Int significand = 0;
+  Int exponent = 0;
+  Int pendingZeroCount = 0; // trailing zeros are not multiplied into significand, so '0.500000' fits
+  bool negative = false;
+  bool digitFound = false;
+  bool pointFound = false;
+
+  Int i = 0;
+  if (i < word.size() && (word.at(i) == '-' || word.at(i) == '+')) {
+    negative = word.at(i) == '-';
+    i++;
+  }
+  for (; i < word.size(); i++) {
+    char c = word.at(i);
+    if (c == '.' && !pointFound) {
+      pointFound = true;
+    }
+    else if (std::isdigit(c)) {
+      digitFound = true;
+      if (pointFound) exponent--;
+      if (c == '0') {
+        pendingZeroCount++;
+        continue;
+      }
+      for (Int j = 0; j <= pendingZeroCount; j++) {
+        if (significand > DUMMY_MAX_INT / 10) return false;
+        significand *= 10;
+      }
+      if (significand > DUMMY_MAX_INT - (c - '0')) return false;
+      significand += c - '0';
+      pendingZeroCount = 0;
+    }
+    else if ((c == 'e' || c == 'E') && digitFound) {
+      string exponentWord = word.substr(i + 1);
+      if (exponentWord.empty() || exponentWord.size() > 6 || exponentWord.find_first_not_of("+-0123456789") != string::npos) return false;
+      try {
+        exponent += std::stoll(exponentWord);
+      }
+      catch (const std::exception &) {
+        return false;
+      }
+      break;
+    }
+    else {
+      return false;
+    }
+  }
+  if (!digitFound) return false;
+
+  exponent += pendingZeroCount;
+  decimal = significand == 0 ? Decimal(0, 0) : Decimal(negative ? -significand : significand, exponent);
+  return true;
+}
+
+bool util::alignDecimal(Int &significand, const Decimal &decimal, Int exponent) {
+  if (exponent > decimal.second) return false;
+
+  significand = decimal.first;
+  for (Int i = exponent; i < decimal.second; i++) {
+    if (std::abs(significand) > DUMMY_MAX_INT / 10) return false;
+    significand *= 10;
+  }
+  return true;
+}
+
+Int util::getResidue(Float integer, Int modulus) {
+  Int residue = std::fmod(integer, modulus);
+  return residue < 0 ? residue + modulus : residue;
+}
+
+Int util::multiplyModularly(Int a, Int b, Int modulus) {
+  return a * b % modulus;
+}
+
+Int util::invertModularly(Int a, Int modulus) { // a^(modulus - 2) by Fermat's little theorem
+  Int inverse = 1;
+  for (Int exponent = modulus - 2; exponent > 0; exponent /= 2) {
+    if (exponent % 2 == 1) inverse = multiplyModularly(inverse, a, modulus);
+    a = multiplyModularly(a, a, modulus);
+  }
+  return inverse;
+}
+
+vector<Int> util::getLargestPrimes(Int bound, Int count) {
+  vector<Int> primes;
+  for (Int n = bound - 1; n > 2 && primes.size() < count; n--) {
+    if (n % 2 == 0) continue;
+
+    bool prime = true;
+    for (Int divisor = 3; divisor * divisor <= n; divisor += 2) {
+      if (n % divisor == 0) {
+        prime = false;
+        break;
+      }
+    }
+    if (prime) primes.push_back(n);
+  }
+  if (primes.size() < count) showError("not enough primes below " + to_string(bound));
+  return primes;
+}
+
+string util::reconstructDecimal(const vector<Int> &residues, const vector<Int> &moduli, Int exponent) {
+  /* mixed-radix digits: integer == digits[0] + digits[1] * moduli[0] + digits[2] * moduli[0] * moduli[1] + ... */
+  vector<Int> digits;
+  for (Int i = 0; i < moduli.size(); i++) {
+    Int modulus = moduli.at(i);
+    Int value = 0; // of earlier digits, modulo modulus
+    Int radix = 1; // product of earlier moduli, modulo modulus
+    for (Int j = 0; j < i; j++) {
+      value = (value + multiplyModularly(digits.at(j), radix, modulus)) % modulus;
+      radix = multiplyModularly(radix, moduli.at(j) % modulus, modulus);
+    }
+    Int difference = (residues.at(i) - value + modulus) % modulus;
+    digits.push_back(multiplyModularly(difference, invertModularly(radix, modulus), modulus));
+  }
+
+  /* Horner's rule in base 10^9, least significant limb first: */
+  const Int limbBase = 1000000000;
+  vector<Int> limbs;
+  for (Int i = moduli.size() - 1; i >= 0; i--) {
+    Int carry = digits.at(i);
+    for (Int &limb : limbs) {
+      Int value = limb * moduli.at(i) + carry; // < 2^61
+      limb = value % limbBase;
+      carry = value / limbBase;
+    }
+    for (; carry > 0; carry /= limbBase) limbs.push_back(carry % limbBase);
+  }
+  if (limbs.empty()) return "0";
+
+  std::ostringstream digitStream;
+  digitStream << limbs.back();
+  for (Int i = limbs.size() - 2; i >= 0; i--) {
+    digitStream << std::setw(9) << std::setfill('0') << limbs.at(i);
+  }
+  string decimalString = digitStream.str();
+
+  if (exponent >= 0) return decimalString + string(exponent, '0');
+
+  Int fractionLength = -exponent;
+  if (decimalString.size() <= fractionLength) {
+    decimalString = string(fractionLength + 1 - decimalString.size(), '0') + decimalString;
+  }
+  decimalString.insert(decimalString.size() - fractionLength, ".");
+  decimalString.erase(decimalString.find_last_not_of('0') + 1); // trailing zeros of fraction
+  if (decimalString.back() == '.') decimalString.pop_back();
+  return decimalString;
+}
+
 /* functions: timing **********************************************************/
 
 TimePoint util::getTimePoint() {
@@ -0,0 +1,96 @@
+#pragma once
+
+/* inclusions *****************************************************************/
+
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+#include "formula.hpp"
+
+/* constants ******************************************************************/
+
+extern const Int SUBFORMULA_CACHE_CAPACITY; // max number of ADDs kept by online caching
+
+extern const string &RESULT_FILE_EXTENSION;
+extern const string &RESULT_LOCK_FILE_NAME;
+
+/* classes ********************************************************************/
+
+class SubformulaKey { // identifies a sub-formula up to renaming of cnf vars
+public:
+  HashPair hashes;
+  vector<Int> boundaryCnfVars; // unprojected cnf vars, in canonical order
+};
+
+class Hasher {
+protected:
+  HashPair hashes = HashPair(0x243f6a8885a308d3, 0x13198a2e03707344);
+
+public:
+  void mix(Hash word);
+  void mixFloat(Float f); // bitwise
+  HashPair getHashes() const;
+};
+
+class SubformulaHasher : public Hasher { // renames cnf vars by order of first occurrence
+protected:
+  Map<Int, Int> canonicalVars; // cnfVar |-> canonical var (0-indexing)
+  vector<Int> cnfVars; // canonical var |-> cnfVar
+  Set<Int> projectedCnfVars;
+
+  Int getCanonicalVar(Int cnfVar); // adds cnfVar if new
+
+public:
+  void addClause(const vector<Int> &clause);
+  void addSubformula(const SubformulaKey &key);
+  void addProjectedCnfVars(const Set<Int> &projectingCnfVars, const Map<Int, Float> &literalWeights);
+  SubformulaKey getKey() const;
+};
+
+class SubformulaCache { // ADDs of sub-formulas, with cnf vars of boundaries
+protected:
+  class Entry {
+  public:
+    ADD dd;
+    Int ddExponent = 0; // log2 of scale divided out of dd (if extendedRange)
+    Int roundingCount = 0; // terminal roundings that dd went through (if epsilon > 0)
+    vector<Int> boundaryCnfVars;
+    Int remainingUses = DUMMY_MAX_INT; // for keys counted beforehand
+  };
+
+  std::map<HashPair, Int> occurrenceCounts; // counted before a traversal
+  std::map<HashPair, Entry> entries;
+  std::deque<HashPair> insertionOrder; // for online caching
+
+  Int hitCount = 0;
+  Int missCount = 0;
+
+public:
+  void countOccurrence(const SubformulaKey &key);
+  bool isRecurrent(const SubformulaKey &key) const; // counted more than once
+  bool lookUp(ADD &dd, Int &ddExponent, Int &roundingCount, vector<Int> &boundaryCnfVars, const SubformulaKey &key); // releases entry after last counted use
+  void insert(const ADD &dd, Int ddExponent, Int roundingCount, const SubformulaKey &key); // keeps entry until its counted uses are over
+  void insertOnline(const ADD &dd, const SubformulaKey &key); // evicts oldest entry if full
+  void printStats() const;
+};
+
+class ResultCache { // model counts in a directory shared by processes on one host
+protected:
+  string dirPath;
+  Float maxMegabytes;
+  bool usable = true;
+
+  string getEntryPath(const HashPair &hashes) const;
+
+public:
+  static HashPair getCnfHashes(const Cnf &cnf); // normalized clauses, literal weights, weight format
+
+  bool lookUp(ExtendedFloat &modelCount, const HashPair &hashes) const; // marks entry as recently used
+  void insert(const ExtendedFloat &modelCount, const HashPair &hashes, const string &source, Float seconds) const; // atomic
+  void evict() const; // removes least recently used entries beyond maxMegabytes
+  ResultCache(const string &dirPath, Float maxMegabytes);
+};
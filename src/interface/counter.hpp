@@ -2,35 +2,151 @@
 
 /* inclusions *****************************************************************/
 
+#include "cache.hpp"
 #include "formula.hpp"
 #include "join.hpp"
+#include "storage.hpp"
 #include "visual.hpp"
 
+/* constants ******************************************************************/
+
+extern const Float COUNTING_SECONDS_PER_JOIN_TREE_COST; // unmeasured guess: join tree cost bounds ADD nodes (2^width per nonterminal), and CUDD handles roughly 10^7 nodes per second; restarts compare costs, so only adaptive planning waits depend on this scale
+extern const Float MAX_EXACT_FLOAT_INT; // 2^53; greater unweighted counts may be rounded
+extern const Int RESCALING_MIN_EXPONENT; // ADD is rescaled once its max magnitude leaves [2^-this, 2^this] (if extendedRange)
+
 /* namespaces *****************************************************************/
 
 namespace diagram {
   Float getTerminalValue(const ADD &terminal);
   Float countConstDdFloat(const ADD &dd);
   Int countConstDdInt(const ADD &dd);
+  string countBddMintermsExactly(const BDD &bdd, Int varCount); // decimal digits
   void printMaxDdVarCount(Int maxDdVarCount);
 }
 
 /* classes ********************************************************************/
 
+/* semirings: compile-time policies for templated ADD operations of Counter; terminal operators return nullptr unless both operands are constant */
+
+class SumProduct { // weighted model counting
+public:
+  static Float getTerminal(Float weight);
+  static DdNode *addTerminals(DdManager *ddManager, DdNode **f, DdNode **g);
+  static DdNode *multiplyTerminals(DdManager *ddManager, DdNode **f, DdNode **g);
+};
+
+class MaxProduct { // max weight of a model (MPE)
+public:
+  static Float getTerminal(Float weight);
+  static DdNode *addTerminals(DdManager *ddManager, DdNode **f, DdNode **g); // max
+  static DdNode *multiplyTerminals(DdManager *ddManager, DdNode **f, DdNode **g);
+};
+
+class LogSumExp { // weighted model counting with natural logs of weights as terminals, which never underflow
+public:
+  static Float getTerminal(Float weight); // -inf for 0
+  static DdNode *addTerminals(DdManager *ddManager, DdNode **f, DdNode **g); // log(exp(f) + exp(g))
+  static DdNode *multiplyTerminals(DdManager *ddManager, DdNode **f, DdNode **g); // f + g
+  static DdNode *convertIndicatorTerminal(DdManager *ddManager, DdNode *node); // monadic: 1 to 0 and 0 to -inf
+};
+
+class ModularSumProduct { // exact residues modulo terminalModulus of count with integer weights
+public:
+  static Float getTerminal(Float weight); // residue of integer weight
+  static DdNode *addTerminals(DdManager *ddManager, DdNode **f, DdNode **g);
+  static DdNode *multiplyTerminals(DdManager *ddManager, DdNode **f, DdNode **g);
+};
+
 class Counter { // abstract
 protected:
+  class SubtreeFrame { // nonterminal being counted by countSubtree
+  public:
+    Int nodeIndex;
+    Int finishedChildCount;
+    ADD dd; // product of finished children, except spilled ones
+    vector<Int> spilledDdIds; // products of earlier children (if spilling)
+    vector<JoinNode *> children; // in execution order
+    const SubformulaKey *key; // recurrent key for caching result; nullptr if none
+    Int startDdExponent; // ddExponent when frame was pushed, so cached result keeps its own scale
+    Int startRoundingCount; // roundingCount when frame was pushed, so cached result keeps its own error
+    Float constantFactor; // product of constant children, kept out of dd (mantissa if extendedRange)
+    vector<ADD> childDds; // finished children, multiplied when nonterminal finishes (unless multiplicationSchedule is LEFT_TO_RIGHT)
+  };
+
+  class MarginalFrame { // nonterminal kept from forward pass to backward pass of computeMarginals
+  public:
+    vector<ADD> factors; // messages of nonterminal children, then conjunction of terminal children
+    vector<Set<Int>> factorDdVarSets; // factorIndex |-> ddVars of domain of factor
+    vector<JoinNode *> factorChildren; // factorIndex |-> nonterminal child; nullptr for terminals
+    Set<Int> projectingDdVars;
+    Set<Int> boundaryDdVars; // domain of message to parent
+  };
+
   static WeightFormat weightFormat;
+  static bool checkpointing; // counting algorithm has safe points
+  static volatile sig_atomic_t checkpointRequested; // by SIGTERM
+  static Int roundingBits; // mantissa bits kept by roundTerminal (if epsilon > 0)
 
   Int dotFileIndex = 1;
   Cudd mgr;
   VarOrderingHeuristic ddVarOrderingHeuristic;
   bool inverseDdVarOrdering;
   Map<Int, Int> cnfVarToDdVarMap; // e.g. {42: 0, 13: 1}
-  vector<Int> ddVarToCnfVarMap; // e.g. [42, 13], i.e. ddVarOrdering
-
-  JoinNonterminal *joinRoot;
+  vector<Int> ddVarToCnfVarMap; // e.g. [42, 13], i.e. ddVarOrdering; 0 for free ddVar (if localDdVars)
+  vector<Int> cnfVarRanks; // cnfVar |-> position in intended ddVar ordering (if localDdVars)
+  std::map<Int, Int> liveDdVars; // rank of live cnfVar |-> its ddVar, whose levels follow ranks (if localDdVars)
+  Int maxLiveDdVarCount = 0; // (if localDdVars)
+  Int ddVarCompactionCount = 0; // (if localDdVars)
+  Int ddExponent = 0; // log2 of scales divided out of ADDs in current count (if extendedRange)
+  Int roundingCount = 0; // terminal roundings in current count, each with relative error at most 2^-roundingBits (if epsilon > 0)
+  Int totalRoundingCount = 0; // over all finished counts, e.g. of components (if epsilon > 0)
+
+  JoinTree *joinTree = nullptr; // arena of constructed join tree (unless joinRoot is read by joinTreeReader)
+  JoinNode *joinRoot;
+  bool countingComponents = true; // false if joinRoot is fixed for entire cnf
+
+  SubformulaCache subformulaCache; // (if subformulaCaching)
+  Map<Int, SubformulaKey> subtreeKeys; // nonterminal index |-> key (if subformulaCaching)
+
+  string checkpointAlgorithm; // (if checkpointDir is set)
+  HashPair cnfHashes; // (if checkpointDir is set)
+  TimePoint checkpointTime; // of last checkpoint (if checkpointDir is set)
+  bool resuming = false; // restoredCheckpoint matches cnf and algorithm
+  Checkpoint restoredCheckpoint;
+  Map<Int, Int> restoredFrameIndices; // nonterminal index |-> ddIndex in restoredCheckpoint (if resuming join tree)
+  vector<SubtreeFrame> subtreeFrames; // explicit stack of countSubtree: from root to current nonterminal
+  Map<Int, Int> subtreeLiveDdCounts; // nonterminal index |-> peak number of live ADDs while counting subtree in execution order with multiplicationSchedule
+
+  SpillManager spillManager; // usable if spillDir is set
+
+  JoinTreeReader *joinTreeReader = nullptr; // publishes later join trees (if speculating)
+  Float jtRestartRatio = 0; // restarts count on join tree this many times cheaper than remaining work
+  Int joinTreeCount = 0; // legal join trees seen from joinTreeReader
+  Map<Int, Float> joinNodeCosts; // nonterminal index |-> 2^width (if speculating)
+  Float remainingJoinTreeCost = 0; // of unfinished nonterminals (if speculating)
+  JoinNode *nextJoinRoot = nullptr; // non-null while count is aborted for restart
 
   static void handleSignals(int signal); // `timeout` sends SIGTERM
+  static void handleTermination(int signal); // requests checkpoint at next safe point (if checkpointing)
+  static DdNode *roundTerminal(DdManager *ddManager, DdNode *node); // monadic ADD operator: rounds mantissa of terminal to roundingBits
+
+  void startCheckpointing(const Cnf &cnf, const string &algorithm); // reads restoredCheckpoint if resumingCheckpoint
+  void finishCheckpointing(); // removes checkpoint of finished count
+  bool isCheckpointDue() const;
+  void saveCheckpoint(Checkpoint &checkpoint, Int position, const Set<Int> &projectedCnfVars); // exits if requested by SIGTERM
+  void saveJoinTreeCheckpoint(); // subtreeFrames; projected cnf vars follow from join tree
+  void addJoinTreeHashes(Hasher &hasher, JoinNode *joinRoot) const; // children in execution order
+
+  void startSpilling();
+  void finishSpilling(); // removes spill files
+  void spillSubtreeFrames(); // from root until pressure is relieved
+  ADD getSubtreeFrameDd(const SubtreeFrame &frame) const; // including spilled products
+
+  bool isSpeculating() const;
+  void addJoinNodeCosts(Map<Int, Float> &joinNodeCosts, JoinNode *joinRoot, const Cnf &cnf) const;
+  Float getJoinTreeCost(const Map<Int, Float> &joinNodeCosts) const;
+  Float predictCountingSeconds(JoinNode *joinRoot, const Cnf &cnf) const; // from width of each nonterminal
+  bool isRestartDue(const Cnf &cnf); // writes: nextJoinRoot
 
   void writeDotFile(ADD &dd, const string &dotFileDir = DOT_DIR);
   template<typename T> Set<Int> getCnfVars(const T &ddVars) {
@@ -39,33 +155,100 @@ protected:
     return cnfVars;
   }
   const vector<Int> &getDdVarOrdering() const; // ddVarToCnfVarMap
-  void orderDdVars(const Cnf &cnf); // writes: cnfVarToDdVarMap, ddVarToCnfVarMap
+  void orderDdVars(const Cnf &cnf); // writes: cnfVarToDdVarMap, ddVarToCnfVarMap; reads ADDs of restoredCheckpoint (if resuming)
+  void startLocalDdVars(const Cnf &cnf); // like orderDdVars, but ddVars are assigned later; existing ddVars become free (if localDdVars)
+  void compactDdVars(); // spreads free ddVars evenly between live ones without changing their order, so each gap has at least 2 (if localDdVars)
+  Int assignDdVar(Int cnfVar); // reuses free ddVar between live neighbours of cnfVar in intended ordering, else compacts or inserts new ddVar there; at most 3 ddVars per live one (if localDdVars)
+  void releaseDdVar(Int cnfVar); // once cnfVar is projected, since it occurs in no other ADD (if localDdVars)
   ADD getClauseDd(const vector<Int> &clause) const;
-  void abstract(ADD &dd, Int ddVar, const Map<Int, Float> &literalWeights);
-  void abstractCube(ADD &dd, const Set<Int> &ddVars, const Map<Int, Float> &literalWeights);
-
+  BDD getClauseBdd(const vector<Int> &clause) const;
+  BDD getClausesBdd(const vector<vector<Int>> &clauses, const vector<Int> &clauseIndices) const;
+  ADD getClausesDd(const vector<vector<Int>> &clauses, const vector<Int> &clauseIndices) const; // conjoined as BDDs, then converted to 0/1 ADD once
+  void rescale(ADD &dd); // divides dd by power of 2 near its max magnitude, which is added to ddExponent (if extendedRange)
+  void roundTerminals(ADD &dd); // merges terminals within relative distance epsilon, which shrinks dd (if epsilon > 0)
+  void normalize(ADD &dd); // after each multiplication or abstraction: rescales and rounds terminals
+  Float getRelativeErrorBound() const; // of counts finished so far, excluding float arithmetic error (if epsilon > 0 and weights are nonnegative)
+  ExtendedFloat countConstDd(const ADD &dd) const; // undoes rescaling
+  ADD applyDds(DD_AOP terminalOperator, const ADD &f, const ADD &g) const;
+  template<typename S> void multiplyDdsIn(ADD &dd, const ADD &factor) const; // S: semiring class
+  template<typename S> void abstractIn(ADD &dd, Int ddVar, const Map<Int, Float> &literalWeights) const; // any weights
+  template<typename S> void abstractCubeIn(ADD &dd, const Set<Int> &ddVars, const Cnf &cnf); // var by var, except for specialization
+  Float getSemiringTerminal(Float weight) const; // dispatches on semiring
+  ADD getOneDd() const; // of semiring
+  ADD getZeroDd() const; // of semiring
+  ADD convertIndicatorDd(const ADD &dd) const; // from 0/1 terminals to zero and one of semiring
+  void multiplyDds(ADD &dd, const ADD &factor) const; // dispatches on semiring
+  bool isZeroDd(const ADD &dd) const; // whole count is 0 once any factor is
+  void multiplyConstant(Float &constantFactor, Float constant); // moves exponent of product to ddExponent (if extendedRange)
+  bool extractConstant(Float &constantFactor, const ADD &dd); // multiplies nonzero constant dd into constantFactor instead of into ADD product (if semiring has linear terminals)
+  void foldConstant(ADD &dd, Float &constantFactor); // multiplies constantFactor back into dd, e.g. before caching or checkpointing; resets constantFactor to 1
+  void abstractCube(ADD &dd, const Set<Int> &ddVars, const Cnf &cnf); // dispatches on semiring
+  ADD multiplyScheduled(vector<ADD> &dds, const Set<Int> &projectingDdVars, const Cnf &cnf); // empties dds; next pair by multiplicationSchedule (not LEFT_TO_RIGHT); abstracts each projecting ddVar once no other operand has it
+  ADD renameCnfVars(const ADD &dd, const vector<Int> &oldCnfVars, const vector<Int> &newCnfVars) const; // permutes ddVars accordingly
+  SubformulaKey getClauseKey(const vector<Int> &clause) const;
+  void sumDdVars(ADD &dd, const Set<Int> &ddVars); // unweighted
+  void multiplyLiteralWeights(ADD &dd, const Set<Int> &ddVars, const Map<Int, Float> &literalWeights); // vars stay in dd
+  void addMarginals(Map<Int, Float> &marginals, const ADD &dd, const vector<Int> &ddVars, Float factor, const Cnf &cnf); // dd depends only on ddVars; halves ddVars recursively
+
+  void startJoinTree(const Cnf &cnf, Int terminalCount); // replaces joinTree; terminal index is clause index
   void printJoinTree(const Cnf &cnf) const;
 
 public:
   virtual void constructJoinTree(const Cnf &cnf) = 0; // handles cnf without empty clause
   void setJoinTree(const Cnf &cnf); // handles cnf with/without empty clause
 
-  ADD countSubtree(JoinNode *joinNode, const Cnf &cnf, Set<Int> &projectedCnfVars); // handles cnf without empty clause
-  Float countJoinTree(const Cnf &cnf); // handles cnf with/without empty clause
-
-  virtual Float computeModelCount(const Cnf &cnf) = 0; // handles cnf without empty clause
-  Float getModelCount(const Cnf &cnf); // handles cnf with/without empty clause
+  void fillSubtreeKeys(JoinNode *joinRoot, const Cnf &cnf, const Map<Int, Float> &literalWeights); // writes: subtreeKeys
+  void fillSubtreeLiveDdCounts(JoinNode *joinRoot); // writes: subtreeLiveDdCounts
+  Int getSubtreeLiveDdCount(JoinNode *joinNode) const;
+  vector<JoinNode *> getExecutionChildren(JoinNode *joinNode) const; // subtree needing most live ADDs first, while product of parent is still trivial
+  void addSubtreeProjectableCnfVars(Set<Int> &projectedCnfVars, JoinNode *joinRoot) const;
+  bool pushSubtreeFrame(JoinNode *joinNode, ADD &cachedDd); // returns false and writes cachedDd if subtree is cached
+  ADD countSubtree(JoinNode *joinRoot, const Cnf &cnf); // post-order with explicit stack; each child ADD is multiplied into product of parent once ready (if multiplicationSchedule is LEFT_TO_RIGHT) or once its siblings are finished; handles cnf without empty clause
+  ADD countJoinTreeDd(const Cnf &cnf); // restarts on cheaper join tree (if speculating); handles cnf without empty clause
+  ExtendedFloat countJoinTree(const Cnf &cnf); // handles cnf with/without empty clause
+
+  virtual ExtendedFloat computeModelCount(const Cnf &cnf) = 0; // handles cnf without empty clause
+  ExtendedFloat getModelCount(const Cnf &cnf); // handles cnf with/without empty clause
+  ExtendedFloat getCachedModelCount(const Cnf &cnf, const string &cnfFilePath); // uses result cache if resultCacheDir is set
+  string getExactModelCount(const Cnf &cnf); // unweighted; conjoins all clauses as BDD, then counts minterms without rounding
+  virtual void prepareModularRuns(const Cnf &integerWeightCnf); // before runs are forked, e.g. reads join tree once
+  virtual ExtendedFloat countModularly(const Cnf &integerWeightCnf); // in forked run (if semiring is MODULAR_SUM_PRODUCT)
+  std::pair<pid_t, int> startModularRun(const Cnf &integerWeightCnf, Int modulus); // forks child with own copy of manager; returns pid and read end of pipe
+  Int finishModularRun(const std::pair<pid_t, int> &modularRun); // residue of count
+  string getExactWeightedModelCount(const Cnf &cnf); // concurrent modular runs with distinct primes, then Chinese remaindering; needs nonnegative decimal weights
+  Map<Int, Float> computeMarginals(const Cnf &cnf, Float &modelCount); // literal |-> derivative of weighted count wrt literal weight; forward pass keeps messages of join tree, backward pass sends outside ADDs to children
+  void outputMarginals(const Cnf &cnf);
+  ExtendedFloat countCube(const ADD &queryDd, const vector<Int> &cube, const Cnf &cnf); // queryDd is over query vars; sums unassigned query vars; excludes other vars in no clause
+  void answerQueries(const Cnf &cnf); // compiles queryDd once, then counts each cube read from queryFilePath
 
   void output(const string &filePath, WeightFormat weightFormat, OutputFormat outputFormat);
+  virtual ~Counter(); // deletes join tree and joinTreeReader
 };
 
 class JoinTreeCounter : public Counter {
+protected:
+  string jtFilePath; // DUMMY_STR if join tree is planned
+  string jtPlannerCommand; // DUMMY_STR if join tree is read
+  bool jtPlannerGraph; // planner reads primal graph (PACE gr) instead of cnf
+  Float jtWaitSeconds;
+  Float jtMinWaitSeconds;
+  Float jtAdaptiveFactor;
+
+  void readJoinTree(const Cnf &cnf, bool speculating); // validates binary jt file
+
 public:
-  void constructJoinTree(const Cnf &cnf) override;
-  Float computeModelCount(const Cnf &cnf) override;
+  void constructJoinTree(const Cnf &cnf) override; // reads or plans join tree
+  ExtendedFloat computeModelCount(const Cnf &cnf) override;
+  void prepareModularRuns(const Cnf &integerWeightCnf) override; // forked runs share joinRoot instead of each reading stdin or spawning planner
+  ExtendedFloat countModularly(const Cnf &integerWeightCnf) override;
   JoinTreeCounter(
     const string &jtFilePath,
+    const string &jtPlannerCommand,
+    bool jtPlannerGraph,
     Float jtWaitSeconds,
+    Float jtMinWaitSeconds,
+    Float jtAdaptiveFactor,
+    Float jtRestartRatio,
     VarOrderingHeuristic ddVarOrderingHeuristic,
     bool inverseDdVarOrdering
   );
@@ -73,12 +256,11 @@ public:
 
 class MonolithicCounter : public Counter { // builds an ADD for the entire CNF
 protected:
-  void setMonolithicClauseDds(vector<ADD> &clauseDds, const Cnf &cnf);
   void setCnfDd(ADD &cnfDd, const Cnf &cnf);
 
 public:
   void constructJoinTree(const Cnf &cnf) override;
-  Float computeModelCount(const Cnf &cnf) override;
+  ExtendedFloat computeModelCount(const Cnf &cnf) override;
   MonolithicCounter(
     VarOrderingHeuristic ddVarOrderingHeuristic,
     bool inverseDdVarOrdering
@@ -96,7 +278,7 @@ protected:
 
 public:
   void constructJoinTree(const Cnf &cnf) override;
-  Float computeModelCount(const Cnf &cnf) override;
+  ExtendedFloat computeModelCount(const Cnf &cnf) override;
   LinearCounter(
     VarOrderingHeuristic ddVarOrderingHeuristic,
     bool inverseDdVarOrdering
@@ -112,10 +294,13 @@ protected:
 
   vector<Set<Int>> occurrentCnfVarSets; // clusterIndex |-> cnfVars
   vector<Set<Int>> projectableCnfVarSets; // clusterIndex |-> cnfVars
-  vector<vector<JoinNode *>> joinNodeSets; // clusterIndex |-> non-null nodes
+  vector<vector<Int>> joinNodeSets; // clusterIndex |-> node indexes in joinTree
 
-  vector<vector<ADD>> ddClusters; // clusterIndex |-> ADDs (if usingTreeClustering)
+  vector<vector<ADD>> ddClusters; // clusterIndex |-> intermediate ADDs; clause ADDs are built when cluster is processed (if usingTreeClustering)
   vector<Set<Int>> projectingDdVarSets; // clusterIndex |-> ddVars (if usingTreeClustering)
+  vector<vector<SubformulaKey>> keyClusters; // clusterIndex |-> keys of ADDs in ddClusters (if usingTreeClustering && subformulaCaching)
+  vector<vector<Int>> spilledDdIdClusters; // clusterIndex |-> spilled ADDs removed from ddClusters (if usingTreeClustering)
+  vector<vector<SubformulaKey>> spilledKeyClusters; // clusterIndex |-> keys of spilled ADDs (if usingTreeClustering && subformulaCaching)
 
   void printClusters(const vector<vector<Int>> &clauses) const;
   void fillClusters(const vector<vector<Int>> &clauses, const vector<Int> &cnfVarOrdering, bool usingMinVar);
@@ -125,9 +310,15 @@ protected:
   void fillCnfVarSets(const vector<vector<Int>> &clauses, bool usingMinVar); // writes: occurrentCnfVarSets, projectableCnfVarSets
 
   Set<Int> getProjectingDdVars(Int clusterIndex, bool usingMinVar, const vector<Int> &cnfVarOrdering, const vector<vector<Int>> &clauses);
-  void fillDdClusters(const vector<vector<Int>> &clauses, const vector<Int> &cnfVarOrdering, bool usingMinVar); // (if usingTreeClustering)
+  void fillDdClusters(const vector<vector<Int>> &clauses, const vector<Int> &cnfVarOrdering, bool usingMinVar); // without clause ADDs (if usingTreeClustering)
   void fillProjectingDdVarSets(const vector<vector<Int>> &clauses, const vector<Int> &cnfVarOrdering, bool usingMinVar); // (if usingTreeClustering)
 
+  vector<Int> getCnfVarOrdering(const Cnf &cnf) const; // from restoredCheckpoint if resuming
+  Int restoreDdClusters(ADD &cnfDd, Set<Int> &projectedCnfVars); // returns next clusterIndex (if usingTreeClustering)
+  void saveTreeClusteringCheckpoint(Int clusterIndex, const vector<Int> &cnfVarOrdering, const ADD &cnfDd, const Set<Int> &projectedCnfVars);
+  void spillDdClusters(Int clusterIndex, bool cachingSubformulas); // pending ADDs of latest clusters until pressure is relieved
+  void reloadDdCluster(Int clusterIndex, bool cachingSubformulas);
+
   Int getTargetClusterIndex(Int clusterIndex) const; // returns DUMMY_MAX_INT if no var remains
   Int getNewClusterIndex(const ADD &abstractedClusterDd, const vector<Int> &cnfVarOrdering, bool usingMinVar) const; // returns DUMMY_MAX_INT if no var remains (if usingTreeClustering)
   Int getNewClusterIndex(const Set<Int> &remainingDdVars) const; // returns DUMMY_MAX_INT if no var remains (if usingTreeClustering) #MAVC
@@ -135,15 +326,15 @@ protected:
   void constructJoinTreeUsingListClustering(const Cnf &cnf, bool usingMinVar);
   void constructJoinTreeUsingTreeClustering(const Cnf &cnf, bool usingMinVar);
 
-  Float countUsingListClustering(const Cnf &cnf, bool usingMinVar);
-  Float countUsingTreeClustering(const Cnf &cnf, bool usingMinVar);
-  Float countUsingTreeClustering(const Cnf &cnf); // #MAVC
+  ExtendedFloat countUsingListClustering(const Cnf &cnf, bool usingMinVar);
+  ExtendedFloat countUsingTreeClustering(const Cnf &cnf, bool usingMinVar);
+  ExtendedFloat countUsingTreeClustering(const Cnf &cnf); // #MAVC
 };
 
 class BucketCounter : public NonlinearCounter { // bucket elimination
 public:
   void constructJoinTree(const Cnf &cnf) override;
-  Float computeModelCount(const Cnf &cnf) override;
+  ExtendedFloat computeModelCount(const Cnf &cnf) override;
   BucketCounter(
     bool usingTreeClustering,
     VarOrderingHeuristic cnfVarOrderingHeuristic,
@@ -156,7 +347,7 @@ public:
 class BouquetCounter : public NonlinearCounter { // Bouquet's Method
 public:
   void constructJoinTree(const Cnf &cnf) override;
-  Float computeModelCount(const Cnf &cnf) override;
+  ExtendedFloat computeModelCount(const Cnf &cnf) override;
   BouquetCounter(
     bool usingTreeClustering,
     VarOrderingHeuristic cnfVarOrderingHeuristic,
@@ -2,6 +2,8 @@
 
 /* inclusions *****************************************************************/
 
+#include <sstream>
+
 #include "graph.hpp"
 
 /* constants ******************************************************************/
@@ -14,6 +16,17 @@ extern const string &WEIGHT_WORD; // starting a CACHET or MCC weight line
 extern const Float CACHET_DEFAULT_VAR_WEIGHT;
 extern const Float MCC_DEFAULT_LITERAL_WEIGHT;
 
+extern const Int MAX_INTEGER_WEIGHT; // 2^52, so sum of two weights is exact as Float
+
+/* types **********************************************************************/
+
+enum class WeightClass { // of cnf var, by its literal weights; decides cheapest abstraction
+  UNIT, // both weights 1: plain sum
+  EQUAL, // equal weights other than 1: sum times scalar
+  RESTRICTING, // one weight 0: cofactor times scalar
+  GENERAL
+};
+
 /* classes ********************************************************************/
 
 class Label : public vector<Int> { // lexicographic search
@@ -26,11 +39,15 @@ protected:
   WeightFormat weightFormat;
   Int declaredVarCount = DUMMY_MIN_INT; // in cnf file
   Map<Int, Float> literalWeights;
+  Map<Int, Decimal> decimalLiteralWeights; // literal |-> weight as written; missing if weight is no decimal with significand fitting in Int
+  Map<Int, WeightClass> varWeightClasses; // cnfVar |-> class; set once literalWeights are complete
   vector<vector<Int>> clauses;
   vector<Int> apparentVars; // vars appearing in clauses, ordered by 1st appearance
 
   void updateApparentVars(Int literal); // adds var to apparentVars
   void addClause(const vector<Int> &clause); // writes: clauses, apparentVars
+  void setDecimalWeight(Int literal, const string &weightWord); // writes: decimalLiteralWeights
+  void classifyVarWeights(); // writes: varWeightClasses
   Graph getGaifmanGraph() const;
   vector<Int> getAppearanceVarOrdering() const;
   vector<Int> getDeclarationVarOrdering() const;
@@ -41,13 +58,19 @@ protected:
 
 public:
   vector<Int> getVarOrdering(VarOrderingHeuristic varOrderingHeuristic, bool inverse) const;
+  WeightFormat getWeightFormat() const;
   Int getDeclaredVarCount() const;
-  Map<Int, Float> getLiteralWeights() const;
+  const Map<Int, Float> &getLiteralWeights() const;
+  WeightClass getVarWeightClass(Int cnfVar) const;
   Int getEmptyClauseIndex() const; // first (nonnegative) index if found else DUMMY_MIN_INT
   const vector<vector<Int>> &getClauses() const;
   const vector<Int> &getApparentVars() const;
+  vector<Cnf> getComponents() const; // connected via shared vars, which are renumbered by first appearance (requires no empty clause)
+  Cnf getIntegerWeightCnf(Int &decimalExponent) const; // same clauses; weights of each var are scaled by a power of 10 to integers; weighted count of this cnf is that of new cnf times 10^decimalExponent
   void printLiteralWeights() const;
   void printClauses() const;
+  string getDimacsString() const; // without weights, e.g. for planner
+  string getPrimalGraphString() const; // PACE gr format, e.g. for tree decomposer
   Cnf(const string &filePath, WeightFormat weightFormat);
   Cnf(const vector<vector<Int>> &clauses);
 };
@@ -2,7 +2,19 @@
 
 /* inclusions *****************************************************************/
 
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <poll.h>
 #include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
 
 #include "util.hpp"
 
@@ -20,97 +32,205 @@ extern const string &JOIN_TREE_END_WORD;
 extern const string &JT_WORD;
 extern const string &VAR_ELIM_WORD;
 
-/* classes ********************************************************************/
+extern const string &TD_SOLUTION_WORD; // starts PACE tree decomposition
+extern const string &TD_WORD;
+extern const string &TD_BAG_WORD;
 
-class JoinNode { // abstract
-  friend class JoinTreeReader;
+extern const string &BINARY_JOIN_TREE_MAGIC; // first bytes of binary jt file
+extern const Int BINARY_JOIN_TREE_VERSION;
 
-protected:
-  static Int backupNodeCount;
-  static Int backupTerminalCount;
-  static Set<Int> backupNonterminalIndexes;
+extern const Int PLANNER_POLL_MILLISECONDS; // reader checks for stop requests this often
+extern const Float PLANNER_GRACE_SECONDS; // for planner to print last join tree after SIGTERM
+
+/* types **********************************************************************/
 
-  static Int nodeCount;
-  static Int terminalCount;
-  static Set<Int> nonterminalIndexes;
+class JoinNode;
+class JoinTree;
 
-  Int nodeIndex = DUMMY_MIN_INT; // 0-indexing
+using CountingSecondsPredictor = std::function<Float(JoinNode *joinRoot)>;
 
-  /* empty for terminals: */
-  vector<JoinNode *> children;
-  Set<Int> projectableCnfVars;
+template<typename T> class Span { // read-only view of contiguous elements, e.g. in pool of join tree
+protected:
+  const T *first = nullptr;
+  const T *last = nullptr;
 
 public:
-  static void resetStaticFields();
-  static void restoreStaticFields();
+  const T *begin() const { return first; }
+  const T *end() const { return last; }
+  size_t size() const { return last - first; }
+  bool empty() const { return first == last; }
+  const T &at(Int i) const { return first[i]; }
+  Span() {}
+  Span(const T *first, size_t size) : first(first), last(first + size) {}
+};
 
-  bool isTerminal() const;
-  Int getNodeCount() const;
-  Int getTerminalCount() const;
-  Int getNodeIndex() const;
+/* classes ********************************************************************/
 
-  const vector<JoinNode *> &getChildren() const;
-  const Set<Int> &getProjectableCnfVars() const;
-  virtual void printSubtree(const string &prefix = "") const = 0;
-};
+class JoinNodeSpan { // children of nonterminal as node indexes into arena of join tree
+protected:
+  JoinTree *joinTree = nullptr;
+  Span<Int> nodeIndexes;
 
-class JoinTerminal : public JoinNode {
 public:
-  void printSubtree(const string &prefix = "") const override;
-  JoinTerminal();
+  class Iterator {
+  protected:
+    JoinTree *joinTree;
+    const Int *nodeIndex;
+
+  public:
+    JoinNode *operator*() const;
+    Iterator &operator++();
+    bool operator!=(const Iterator &other) const;
+    Iterator(JoinTree *joinTree, const Int *nodeIndex);
+  };
+
+  Iterator begin() const;
+  Iterator end() const;
+  size_t size() const;
+  bool empty() const;
+  JoinNode *at(Int i) const;
+  JoinNodeSpan(JoinTree *joinTree, const Span<Int> &nodeIndexes);
 };
 
-class JoinNonterminal : public JoinNode {
+class JoinNode { // view into arena of join tree; terminals have node indexes 0, ..., terminalCount - 1
+  friend class JoinTree;
+
+protected:
+  JoinTree *joinTree = nullptr;
+  Int nodeIndex = DUMMY_MIN_INT; // 0-indexing; DUMMY_MIN_INT if nonterminal is not read yet
+
+  /* spans in pools of join tree; empty for terminals: */
+  Int childOffset = 0;
+  Int childCount = 0;
+  Int cnfVarOffset = 0;
+  Int cnfVarCount = 0;
+
 public:
-  void printNode(const string &prefix) const;
-  void printSubtree(const string &prefix = "") const override; // post-order
-  void addProjectableCnfVars(const Set<Int> &cnfVars);
-  JoinNonterminal(
-    const vector<JoinNode *> &children,
-    const Set<Int> &projectableCnfVars = Set<Int>(),
-    Int requestedNodeIndex = DUMMY_MIN_INT
-  );
+  JoinTree *getJoinTree() const;
+  bool isTerminal() const;
+  Int getNodeIndex() const;
+
+  JoinNodeSpan getChildren() const;
+  Span<Int> getProjectableCnfVars() const;
+  vector<JoinNode *> getPostorder(); // nonterminals of subtree, children before parents; iterative for deep trees
+  void printNode(const string &prefix = "") const;
+  void printSubtree(const string &prefix = ""); // post-order
 };
 
-class JoinTree {
+class JoinTree { // arena: nodes, children, and projectable cnf vars in contiguous arrays; deleting tree frees all nodes
   friend class JoinTreeReader;
+  friend class JoinNode;
 
 protected:
   Int declaredVarCount = DUMMY_MIN_INT; // in jt file
   Int declaredClauseCount = DUMMY_MIN_INT; // in jt file
-  Int declaredNodeCount = DUMMY_MIN_INT; // in jt file
+  Int declaredNodeCount = DUMMY_MIN_INT; // in jt file; DUMMY_MIN_INT if join tree is constructed by counter
 
-  Map<Int, JoinTerminal *> joinTerminals;
-  Map<Int, JoinNonterminal *> joinNonterminals;
+  Int terminalCount = 0;
+  Int nonterminalCount = 0;
+  vector<JoinNode> joinNodes; // nodeIndex |-> node
+  vector<Int> childPool; // node indexes
+  vector<Int> cnfVarPool; // projectable cnf vars
 
   Float plannerSeconds = NEGATIVE_INFINITY; // cumulative time for all join trees
 
-  JoinNode *getJoinNode(Int nodeIndex) const;
-
 public:
-  JoinNonterminal *getJoinRoot() const;
-  void printTree() const;
+  Int getTerminalCount() const;
+  Int getNonterminalCount() const;
+  Int getNodeCount() const;
+  bool hasJoinNode(Int nodeIndex) const; // false for unread nonterminals
+  JoinNode *getJoinNode(Int nodeIndex);
+  JoinNode *getJoinRoot(); // nonterminal with greatest node index
+  Int addNonterminal(const vector<Int> &childIndexes, const Set<Int> &projectableCnfVars = Set<Int>(), Int requestedNodeIndex = DUMMY_MIN_INT); // returns node index
+  void printTree();
 
-  JoinTree(Int declaredVarCount, Int declaredClauseCount, Int declaredNodeCount);
+  JoinTree(Int declaredVarCount, Int declaredClauseCount, Int declaredNodeCount = DUMMY_MIN_INT); // creates declaredClauseCount terminals
+};
+
+class BinaryJoinTreeHeader { // followed by int64 arrays: childOffsets, elimVarOffsets (nonterminalCount + 1 each), children, elimVars
+public:
+  char magic[8];
+  int64_t version;
+  int64_t declaredVarCount;
+  int64_t clauseCount; // terminals have node indexes 0, ..., clauseCount - 1
+  int64_t nonterminalCount; // in post-order from node index clauseCount; root last
+  uint64_t cnfHashes[2]; // of clauses in order; see storage::getClauseHashes
 };
 
 class JoinTreeReader {
 protected:
-  static Int plannerPid;
+  Int plannerPid = DUMMY_MIN_INT; // spawned or announced in planner comment
+  bool plannerSpawned = false; // child process to be reaped
+  string plannerCommand = DUMMY_STR;
 
   JoinTree *backupJoinTree = nullptr;
   JoinTree *joinTree = nullptr;
+  vector<JoinTree *> startedJoinTrees; // owned; unpublished ones are deleted once superseded
+  Set<const JoinTree *> publishedJoinTrees; // may be counted, so deleted with reader
 
   Int lineIndex = 0;
   Int problemLineIndex = DUMMY_MIN_INT;
   Int joinTreeEndLineIndex = DUMMY_MIN_INT;
 
-  static void handleAlarm(int signal); // `alarm` sends SIGALRM
-
+  const vector<vector<Int>> *clauses; // of cnf; attached to bags of tree decompositions
+  HashPair binaryCnfHashes; // zero unless binary jt file
+  Int tdSolutionLineIndex = DUMMY_MIN_INT; // of tree decomposition being read
+  Int tdDeclaredVertexCount = DUMMY_MIN_INT;
+  vector<vector<Int>> tdBags; // bagIndex |-> cnf vars (0-indexing)
+  vector<bool> tdReadBags; // bagIndex |-> bag line read
+  Int tdReadBagCount = 0;
+  vector<std::pair<Int, Int>> tdEdges;
+
+  Float jtWaitSeconds; // upper bound on planning
+  Float jtMinWaitSeconds; // lower bound on planning if adaptive
+  Float jtAdaptiveFactor; // stops planning at this times predicted counting time of best join tree (0: off)
+  CountingSecondsPredictor predictCountingSeconds;
+  Float bestCountingSeconds = std::numeric_limits<Float>::infinity(); // predicted for legal join trees so far
+  TimePoint readingStartTime;
+  Float planningSeconds = NEGATIVE_INFINITY; // until reading finished
+
+  std::ifstream inputFileStream; // outlives constructor (if speculating)
+  std::thread readingThread; // (if speculating)
+  mutable std::mutex publishingMutex;
+  std::condition_variable publishingCondition;
+  JoinTree *publishedJoinTree = nullptr; // latest legal join tree; immutable
+  Int publishedJoinTreeCount = 0;
+  bool readingFinished = false;
+  bool readingFailed = false; // on reading thread
+  bool stoppingRequested = false;
+
+  static vector<string> getCommandWords(const string &command); // splits on spaces outside quotes
+
+  void startJoinTree(Int declaredVarCount, Int declaredClauseCount, Int declaredNodeCount); // current join tree becomes backup
   void finishReadingJoinTree(); // after reading '=' or end of stream
-  void readInputStream(std::istream *inputStream);
+  void publishJoinTree();
+  void finishReading(bool failed);
+  bool isStoppingRequested() const;
+  void startReadingTreeDecomposition(const vector<string> &words); // after reading 's td'
+  void readTreeDecompositionLine(const vector<string> &words); // bag or edge
+  void finishReadingTreeDecomposition(); // converts to join tree: clause to covering bag, var projected at highest bag containing it
+  void readLine(const string &line);
+  void readInputStream(std::istream *inputStream); // e.g. regular file
+  void readBinaryFile(const string &filePath); // via mmap
+  Float getPlanningDeadlineSeconds() const; // since reading started
+  void readFileDescriptor(int inputFd, int plannerInputFd, const string &plannerInput); // polls with timeout while writing plannerInput to planner stdin
+  void readSafely(const std::function<void()> &reading); // on reading thread, where errors only stop reading
+  void startReading(const std::function<void()> &reading, bool speculating); // returns after first legal join tree
+  void spawnPlanner(int &plannerInputFd, int &plannerOutputFd);
+  void terminatePlanner(); // spawned planner: SIGTERM, then SIGKILL after grace period; reaps
+  void printFirstJoinTreeInfo() const;
 
 public:
-  JoinNonterminal *getJoinTreeRoot() const;
-  JoinTreeReader(const string &filePath, Float jtWaitSeconds);
+  JoinNode *getJoinTreeRoot() const; // of latest legal join tree
+  JoinNode *getJoinTreeRoot(Int &joinTreeCount) const; // also returns number of legal join trees so far
+  static bool isBinaryFile(const string &filePath);
+  static void writeBinaryFile(const string &filePath, JoinNode *joinRoot, Int declaredVarCount, Int clauseCount, const HashPair &cnfHashes); // via temp file and rename
+
+  const HashPair &getBinaryCnfHashes() const;
+  Float getPlanningSeconds() const;
+  Float getBestCountingSeconds() const; // predicted
+  void stopReading(); // terminates planner (if speculating)
+  JoinTreeReader(const string &filePath, const vector<vector<Int>> &clauses, Float jtWaitSeconds, Float jtMinWaitSeconds, Float jtAdaptiveFactor, const CountingSecondsPredictor &predictCountingSeconds, bool speculating); // returns after first legal join tree if speculating; reads jt or PACE td
+  JoinTreeReader(const string &plannerCommand, const string &plannerInput, const vector<vector<Int>> &clauses, Float jtWaitSeconds, Float jtMinWaitSeconds, Float jtAdaptiveFactor, const CountingSecondsPredictor &predictCountingSeconds, bool speculating); // spawns planner with plannerInput on stdin
+  ~JoinTreeReader(); // stops reading, then deletes join trees
 };
@@ -15,13 +15,37 @@ public:
   string cnfFilePath;
   Int weightFormatOption;
   string jtFilePath;
+  string jtPlannerCommand;
+  Int jtPlannerGraphOption;
   Float jtWaitSeconds;
+  Float jtMinWaitSeconds;
+  Float jtAdaptiveFactor;
+  Float jtRestartRatio;
   Int outputFormatOption;
   Int clusteringHeuristicOption;
   Int cnfVarOrderingHeuristicOption;
   Int ddVarOrderingHeuristicOption;
   Int randomSeedOption;
   Int verbosityLevelOption;
+  Int subformulaCachingOption;
+  string resultCacheDirOption;
+  Float resultCacheMegabytesOption;
+  Int resultCacheComponentsOption;
+  string checkpointDirOption;
+  Float checkpointSecondsOption;
+  Int checkpointResumeOption;
+  string spillDirOption;
+  Float spillMegabytesOption;
+  Int exactCountingOption;
+  Int extendedRangeOption;
+  Float epsilonOption;
+  Int marginalsOption;
+  string queryVarsOption;
+  string queryFileOption;
+  Int semiringOption;
+  Int localDdVarsOption;
+  Int multiplicationScheduleOption;
+  string binaryJtFileOption;
 
   cxxopts::Options *options;
 
@@ -35,6 +59,30 @@ public:
 
 namespace testing {
   void test();
+
+  void writeFile(const string &filePath, const string &text);
+  void removeDir(const string &dirPath); // with files and subdirs, e.g. checkpoint dir
+  void checkEqual(const string &actual, const string &expected, const string &description); // showError on mismatch
+  bool isRejected(const std::function<void()> &action); // true if action throws MyError
+  void testDecimals(); // util::parseDecimal and util::reconstructDecimal
+  void testExactWeightedCounting(const string &dirPath); // modular runs against BDD minterm count and hand-computed decimal
+  void testMarginals(const string &dirPath, const Cnf &cnf); // cnf is 4-var weighted formula with var 4 in no clause; backward pass on three join trees against hand-computed derivatives
+  void testCubes(const string &dirPath, const Cnf &cnf); // cnf is as in testMarginals; countCube against counts of cnf with cube as unit clauses
+  class CheckpointInterrupter : public std::streambuf { // discards output; raises SIGTERM once checkpointCount checkpoints are written
+  protected:
+    Int remainingCheckpointCount;
+    string line;
+
+    int overflow(int c) override;
+
+  public:
+    CheckpointInterrupter(Int checkpointCount);
+  };
+  void testCheckpoints(const string &dirPath, const string &cnfFilePath); // linear count stopped by SIGTERM in child process, then resumed in parent
+  string getSubtreeSignature(JoinNode *joinNode); // clause indexes in child order and sorted projectable vars, e.g. '(0 (1 2 | 3) | 1 2)'
+  void testTreeDecompositions(const string &dirPath, const Cnf &cnf, const CountingSecondsPredictor &predictor); // cnf is 4-var chain with 6 models; PACE td converted to join tree; repeated bag is rejected
+  void testBinaryJoinTrees(const string &dirPath, const Cnf &cnf, const CountingSecondsPredictor &predictor); // text jt written as binary jt and read back; corrupt header is rejected
+  bool runChecks(); // behavior checks of exact paths; false on first failure
 }
 
 namespace solving {
@@ -42,7 +90,12 @@ namespace solving {
     const string &cnfFilePath,
     WeightFormat weightFormat,
     const string &jtFilePath,
+    const string &jtPlannerCommand,
+    bool jtPlannerGraph,
     Float jtWaitSeconds,
+    Float jtMinWaitSeconds,
+    Float jtAdaptiveFactor,
+    Float jtRestartRatio,
     OutputFormat outputFormat,
     ClusteringHeuristic clusteringHeuristic,
     VarOrderingHeuristic cnfVarOrderingHeuristic,
@@ -54,7 +107,12 @@ namespace solving {
     const string &cnfFilePath,
     Int weightFormatOption,
     const string &jtFilePath,
+    const string &jtPlannerCommand,
+    Int jtPlannerGraphOption,
     Float jtWaitSeconds,
+    Float jtMinWaitSeconds,
+    Float jtAdaptiveFactor,
+    Float jtRestartRatio,
     Int outputFormatOption,
     Int clusteringHeuristicOption,
     Int cnfVarOrderingHeuristicOption,
@@ -0,0 +1,80 @@
+#pragma once
+
+/* inclusions *****************************************************************/
+
+#include <sstream>
+
+#include "cache.hpp"
+
+/* constants ******************************************************************/
+
+extern const string &CHECKPOINT_LATEST_FILE_NAME;
+extern const string &CHECKPOINT_FILE_PREFIX;
+
+extern const Int SPILL_MIN_NODE_COUNT; // smaller ADDs stay in memory
+
+/* namespaces *****************************************************************/
+
+namespace storage {
+  HashPair getClauseHashes(const Cnf &cnf); // clause order matters but weights do not, e.g. for join trees
+
+  void writeDds(std::ostream &outputStream, const vector<ADD> &dds); // shared nodes written once; terminals in hexadecimal
+  vector<ADD> readDds(std::istream &inputStream, const Cudd &mgr);
+
+  bool writeDdsFile(const string &filePath, const vector<ADD> &dds); // via temp file and rename
+  vector<ADD> readDdsFile(const string &filePath, const Cudd &mgr);
+}
+
+/* classes ********************************************************************/
+
+class Checkpoint { // counting state at a point between ADD operations
+protected:
+  Int generation = DUMMY_MIN_INT; // of files read or written
+
+  static Int readLatestGeneration(const string &dirPath); // DUMMY_MIN_INT if none
+  static string getFilePathPrefix(const string &dirPath, Int generation);
+
+public:
+  string algorithm; // counter that wrote this checkpoint
+  HashPair cnfHashes;
+  Int position = DUMMY_MIN_INT; // meaning depends on algorithm, e.g. next cluster index
+  vector<Int> ddVarOrdering; // ddVar |-> cnfVar; 0 for free ddVar (if localDdVars)
+  vector<Int> ddVarLevels; // ddVar |-> level (if localDdVars)
+  vector<Int> cnfVarOrdering;
+  vector<Int> projectedCnfVars;
+  Int ddExponent = 0; // log2 of scale divided out of dds so far (if extendedRange)
+  Int roundingCount = 0; // terminal roundings so far (if epsilon > 0)
+
+  vector<ADD> dds; // finished intermediate ADDs
+  vector<Int> ddTags; // ddIndex |-> e.g. target cluster index
+  vector<Int> ddPositions; // ddIndex |-> e.g. finished child count
+
+  void write(const string &dirPath); // keeps previous checkpoint until new one is complete
+  bool readMetadata(const string &dirPath); // returns false if no checkpoint
+  void readDds(const string &dirPath, const Cudd &mgr); // after metadata, once ddVars exist
+  static void remove(const string &dirPath);
+};
+
+class SpillManager { // moves idle ADDs to files under memory pressure and back
+protected:
+  string dirPath; // private to this process
+  Float maxNodeCount; // live ADD nodes before spilling
+  bool usable = false;
+  Int nextSpillId = 0;
+  Int spillCount = 0;
+  Int reloadCount = 0;
+
+  string getFilePath(Int spillId) const;
+
+public:
+  bool isUsable() const;
+  bool isUnderPressure(const Cudd &mgr) const;
+  bool isWorthSpilling(const ADD &dd) const;
+  Int spill(const ADD &dd); // returns DUMMY_MIN_INT if unable
+  ADD reload(Int spillId, const Cudd &mgr); // removes file
+  ADD peek(Int spillId, const Cudd &mgr) const; // keeps file
+  void removeFiles(); // and dir; becomes unusable
+  void printStats() const;
+  SpillManager();
+  SpillManager(const string &parentDirPath, Float maxMegabytes);
+};
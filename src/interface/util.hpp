@@ -1,9 +1,9 @@
 /* DAG of inclusions:
-.>>>> graph  >> formula
-^               v
-util >> join >> counter >> main*
-v               ^
-.>>>>>>>>>>>>>> visual
+.>>>> graph  >> formula >> cache >> storage
+^                                     v
+util >> join >>>>>>>>>>>>>>>>>>>>>>>> counter >> main*
+v                                     ^
+.>>>>>>>>>>>> visual >>>>>>>>>>>>>>>>>.
 */
 
 #pragma once
@@ -12,6 +12,7 @@ v               ^
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <deque>
 #include <fstream>
 #include <iomanip>
@@ -19,6 +20,8 @@ v               ^
 #include <iterator>
 #include <map>
 #include <random>
+#include <set>
+#include <sstream>
 #include <unistd.h>
 #include <unordered_map>
 #include <unordered_set>
@@ -38,15 +41,56 @@ using std::vector;
 using Float = double; // std::stod // OPTIL would complain about 'long double'
 using Int = int_fast64_t; // std::stoll
 using TimePoint = std::chrono::time_point<std::chrono::steady_clock>;
+using Hash = uint64_t;
+using HashPair = std::pair<Hash, Hash>; // two independent hashes make collisions negligible
+using Decimal = std::pair<Int, Int>; // (significand, exponent) for significand * 10^exponent, e.g. literal weight as written in cnf file
 
 template<typename K, typename V> using Map = std::unordered_map<K, V>;
 template<typename T> using Set = std::unordered_set<T>;
 
+class ExtendedFloat { // mantissa * 2^exponent, e.g. model count far below least positive Float
+public:
+  Float mantissa = 0; // 0 or in [0.5, 1) in magnitude (unless infinite or NaN)
+  Int exponent = 0;
+
+  Float toFloat() const; // may underflow or overflow
+  Float getLog10() const; // of magnitude; -infinity if 0
+  string toScientificString() const; // e.g. 1.0235e-1234
+  ExtendedFloat operator*(const ExtendedFloat &other) const;
+  ExtendedFloat &operator*=(const ExtendedFloat &other);
+  ExtendedFloat(Float f = 0);
+  ExtendedFloat(Float mantissa, Int exponent); // normalizes
+};
+
+enum class Semiring { SUM_PRODUCT, MAX_PRODUCT, LOG_SUM_EXP, MODULAR_SUM_PRODUCT }; // of counting; see semiring classes in counter.hpp; last one is internal to exact weighted counting
+enum class MultiplicationSchedule { LEFT_TO_RIGHT, SMALLEST_FIRST, MAX_OVERLAP }; // of ADD operands of join node or cluster; see Counter::multiplyScheduled
+
 /* global variables ***********************************************************/
 
 extern Int randomSeed; // for reproducibility
 extern Int verbosityLevel;
 extern TimePoint startTime;
+extern bool subformulaCaching; // reuses ADDs of sub-formulas identical up to var renaming
+extern string resultCacheDir; // DUMMY_STR if no persistent result cache
+extern Float resultCacheMegabytes;
+extern bool resultCachingComponents; // also caches counts of connected components
+extern string checkpointDir; // DUMMY_STR if no checkpointing
+extern Float checkpointSeconds; // between periodic checkpoints
+extern bool resumingCheckpoint; // from latest checkpoint in checkpointDir
+extern string spillDir; // DUMMY_STR if idle ADDs stay in memory
+extern Float spillMegabytes; // of live ADD nodes before spilling
+extern string binaryJtFilePath; // written instead of printing join tree; DUMMY_STR if none
+extern bool exactCounting; // unweighted: one BDD with arbitrary-precision minterm count; weighted: modular runs combined by Chinese remaindering
+extern bool extendedRange; // rescales ADDs by powers of 2 and counts with ExtendedFloat instead of underflowing
+extern bool printingLog10; // prints log10 of model count (if extendedRange)
+extern Float epsilon; // relative tolerance for merging nearby ADD terminals; 0 if exact
+extern bool computingMarginals; // derivatives of weighted count wrt all literal weights, via backward pass over join tree
+extern Set<Int> queryCnfVars; // never projected, so final ADD over them answers cube queries; empty if not querying
+extern string queryFilePath; // cubes, one per line (if queryCnfVars is nonempty)
+extern Semiring semiring; // e.g. MAX_PRODUCT for max weight of a model
+extern Int terminalModulus; // prime of residues in ADD terminals (if semiring is MODULAR_SUM_PRODUCT)
+extern MultiplicationSchedule multiplicationSchedule; // LEFT_TO_RIGHT multiplies each ADD into product once ready
+extern bool localDdVars; // join tree counting maps live cnf vars to recycled ddVars, so manager is about as narrow as width
 
 /* constants ******************************************************************/
 
@@ -62,19 +106,47 @@ extern const string &HELP_OPTION;
 extern const string &CNF_FILE_OPTION;
 extern const string &WEIGHT_FORMAT_OPTION;
 extern const string &JT_FILE_OPTION;
+extern const string &JT_PLANNER_OPTION;
+extern const string &JT_PLANNER_GRAPH_OPTION;
 extern const string &JT_WAIT_DURAION_OPTION;
+extern const string &JT_MIN_WAIT_OPTION;
+extern const string &JT_ADAPTIVE_WAIT_OPTION;
+extern const string &JT_RESTART_RATIO_OPTION;
+extern const string &JT_BINARY_OUTPUT_OPTION;
 extern const string &OUTPUT_FORMAT_OPTION;
 extern const string &CLUSTERING_HEURISTIC_OPTION;
 extern const string &CLUSTER_VAR_ORDER_OPTION;
 extern const string &DIAGRAM_VAR_ORDER_OPTION;
 extern const string &RANDOM_SEED_OPTION;
 extern const string &VERBOSITY_LEVEL_OPTION;
+extern const string &SUBFORMULA_CACHING_OPTION;
+extern const string &RESULT_CACHE_DIR_OPTION;
+extern const string &RESULT_CACHE_MEGABYTES_OPTION;
+extern const string &RESULT_CACHE_COMPONENTS_OPTION;
+extern const string &CHECKPOINT_DIR_OPTION;
+extern const string &CHECKPOINT_SECONDS_OPTION;
+extern const string &CHECKPOINT_RESUME_OPTION;
+extern const string &SPILL_DIR_OPTION;
+extern const string &SPILL_MEGABYTES_OPTION;
+extern const string &EXACT_COUNTING_OPTION;
+extern const string &EXTENDED_RANGE_OPTION;
+extern const string &EPSILON_OPTION;
+extern const string &MARGINALS_OPTION;
+extern const string &QUERY_VARS_OPTION;
+extern const string &QUERY_FILE_OPTION;
+extern const string &SEMIRING_OPTION;
+extern const string &LOCAL_DD_VARS_OPTION;
+extern const string &MULTIPLICATION_SCHEDULE_OPTION;
 
 enum class WeightFormat { UNWEIGHTED, MINIC2D, CACHET, MCC };
 extern const std::map<Int, WeightFormat> WEIGHT_FORMAT_CHOICES;
 extern const Int DEFAULT_WEIGHT_FORMAT_CHOICE;
 
+extern const Int DEFAULT_JT_PLANNER_GRAPH_CHOICE;
 extern const Float DEFAULT_JT_WAIT_SECONDS;
+extern const Float DEFAULT_JT_MIN_WAIT_SECONDS;
+extern const Float DEFAULT_JT_ADAPTIVE_FACTOR;
+extern const Float DEFAULT_JT_RESTART_RATIO;
 
 enum class OutputFormat { JOIN_TREE, MODEL_COUNT };
 extern const std::map<Int, OutputFormat> OUTPUT_FORMAT_CHOICES;
@@ -97,6 +169,34 @@ extern const Int DEFAULT_RANDOM_SEED;
 extern const vector<Int> VERBOSITY_LEVEL_CHOICES;
 extern const Int DEFAULT_VERBOSITY_LEVEL_CHOICE;
 
+extern const Int DEFAULT_SUBFORMULA_CACHING_CHOICE;
+
+extern const Float DEFAULT_RESULT_CACHE_MEGABYTES;
+extern const Int DEFAULT_RESULT_CACHE_COMPONENTS_CHOICE;
+
+extern const Float DEFAULT_CHECKPOINT_SECONDS;
+extern const Int DEFAULT_CHECKPOINT_RESUME_CHOICE;
+
+extern const Float DEFAULT_SPILL_MEGABYTES;
+
+extern const Int DEFAULT_EXACT_COUNTING_CHOICE;
+
+extern const Int DEFAULT_EXTENDED_RANGE_CHOICE;
+
+extern const Float DEFAULT_EPSILON;
+
+extern const Int DEFAULT_MARGINALS_CHOICE;
+
+extern const std::map<Int, Semiring> SEMIRING_CHOICES;
+extern const Int DEFAULT_SEMIRING_CHOICE;
+
+extern const Int DEFAULT_LOCAL_DD_VARS_CHOICE;
+
+extern const std::map<Int, MultiplicationSchedule> MULTIPLICATION_SCHEDULE_CHOICES;
+extern const Int DEFAULT_MULTIPLICATION_SCHEDULE_CHOICE;
+
+extern const Int MAX_MODULUS; // 2^31, so product of two residues fits in Int
+
 extern const Float NEGATIVE_INFINITY;
 
 extern const Int DUMMY_MIN_INT;
@@ -114,7 +214,9 @@ namespace util {
   /* functions: printing ******************************************************/
 
   void printComment(const string &message, Int preceedingNewLines = 0, Int followingNewLines = 1, bool commented = true);
-  void printSolutionLine(WeightFormat weightFormat, Float modelCount, Int preceedingThinLines = 1, Int followingThinLines = 1);
+  string getModelCountString(const ExtendedFloat &modelCount); // log10 or scientific (if extendedRange)
+  void printSolutionLine(WeightFormat weightFormat, const ExtendedFloat &modelCount, Int preceedingThinLines = 1, Int followingThinLines = 1);
+  void printSolutionLine(WeightFormat weightFormat, const string &modelCount, Int preceedingThinLines = 1, Int followingThinLines = 1); // e.g. decimal digits of exact count
 
   void printBoldLine(bool commented);
   void printThickLine(bool commented = true);
@@ -124,23 +226,50 @@ namespace util {
   void printCnfFileOption();
   void printWeightFormatOption();
   void printJtFileOption();
+  void printJtPlannerOption();
+  void printJtPlannerGraphOption();
   void printJtWaitOption();
+  void printJtMinWaitOption();
+  void printJtAdaptiveWaitOption();
+  void printJtRestartOption();
+  void printJtBinaryOutputOption();
   void printOutputFormatOption();
   void printClusteringHeuristicOption();
   void printCnfVarOrderingHeuristicOption();
   void printDdVarOrderingHeuristicOption();
   void printRandomSeedOption();
   void printVerbosityLevelOption();
+  void printSubformulaCachingOption();
+  void printResultCacheDirOption();
+  void printResultCacheMegabytesOption();
+  void printResultCacheComponentsOption();
+  void printCheckpointDirOption();
+  void printCheckpointSecondsOption();
+  void printCheckpointResumeOption();
+  void printSpillDirOption();
+  void printSpillMegabytesOption();
+  void printExactCountingOption();
+  void printExtendedRangeOption();
+  void printEpsilonOption();
+  void printMarginalsOption();
+  void printQueryVarsOption();
+  void printQueryFileOption();
+  void printSemiringOption();
+  void printLocalDdVarsOption();
+  void printMultiplicationScheduleOption();
 
   /* functions: argument parsing **********************************************/
 
   vector<string> getArgV(int argc, char *argv[]);
+  Set<Int> getCnfVars(const string &cnfVarsString); // comma-separated, e.g. '1,5,9'
 
   string getWeightFormatName(WeightFormat weightFormat);
   string getOutputFormatName(OutputFormat outputFormat);
   string getClusteringHeuristicName(ClusteringHeuristic clusteringHeuristic);
   string getVarOrderingHeuristicName(VarOrderingHeuristic varOrderingHeuristic);
   string getVerbosityLevelName(Int verbosityLevel);
+  string getSemiringName(Semiring semiring);
+  string getMultiplicationScheduleName(MultiplicationSchedule multiplicationSchedule);
 
   /* functions: CNF ***********************************************************/
 
@@ -159,6 +288,16 @@ namespace util {
   void printCnf(const vector<vector<Int>> &clauses);
   void printLiteralWeights(const Map<Int, Float> &literalWeights);
 
+  /* functions: exact arithmetic *********************************************/
+
+  bool parseDecimal(Decimal &decimal, const string &word); // false unless word is a decimal with significand fitting in Int, e.g. '0.25' or '1e-3'
+  bool alignDecimal(Int &significand, const Decimal &decimal, Int exponent); // significand * 10^exponent == decimal; false on overflow
+  Int getResidue(Float integer, Int modulus); // in [0, modulus)
+  Int multiplyModularly(Int a, Int b, Int modulus); // a, b < modulus <= MAX_MODULUS
+  Int invertModularly(Int a, Int modulus); // prime modulus
+  vector<Int> getLargestPrimes(Int bound, Int count); // below bound, descending
+  string reconstructDecimal(const vector<Int> &residues, const vector<Int> &moduli, Int exponent); // nonnegative integer from residues by Chinese remaindering (Garner), times 10^exponent, in decimal digits
+
   /* functions: timing ********************************************************/
 
   TimePoint getTimePoint();
@@ -239,8 +378,8 @@ namespace util {
     return true;
   }
 
-  template<typename T> Float adjustModelCount(Float apparentModelCount, const T &projectedCnfVars, const Map<Int, Float> &literalWeights) {
-    Float totalModelCount = apparentModelCount;
+  template<typename T> ExtendedFloat adjustModelCount(const ExtendedFloat &apparentModelCount, const T &projectedCnfVars, const Map<Int, Float> &literalWeights) {
+    ExtendedFloat totalModelCount = apparentModelCount;
 
     Int totalLiteralCount = literalWeights.size();
     if (totalLiteralCount % 2 == 1) showError("odd total literal count");
@@ -250,11 +389,19 @@ namespace util {
 
     for (Int cnfVar = 1; cnfVar <= totalVarCount; cnfVar++) {
       if (!isFound(cnfVar, projectedCnfVars)) {
-        totalModelCount *= literalWeights.at(cnfVar) + literalWeights.at(-cnfVar);
+        Float positiveWeight = literalWeights.at(cnfVar);
+        Float negativeWeight = literalWeights.at(-cnfVar);
+        if (semiring == Semiring::MODULAR_SUM_PRODUCT) { // residue stays exact
+          totalModelCount = multiplyModularly(getResidue(totalModelCount.toFloat(), terminalModulus), getResidue(positiveWeight + negativeWeight, terminalModulus), terminalModulus);
+        }
+        else {
+          totalModelCount *= semiring == Semiring::MAX_PRODUCT ? std::max(positiveWeight, negativeWeight) : positiveWeight + negativeWeight;
+        }
       }
     }
 
-    if (totalModelCount == 0) {
+    if (semiring == Semiring::MODULAR_SUM_PRODUCT) return totalModelCount; // 0 is no underflow
+    if (extendedRange ? totalModelCount.mantissa == 0 : totalModelCount.toFloat() == 0) {
       showWarning("floating-point underflow may have occured");
     }
     return totalModelCount;